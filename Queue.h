@@ -0,0 +1,51 @@
+/*
+ * File:	Queue.h
+ *
+ * Description:	This file contains the class definition for a bounded,
+ *		lock-free queue between exactly one producer thread and
+ *		exactly one consumer thread.  The queue is a ring of N
+ *		slots, with N a power of two.  The producer owns the tail
+ *		and the consumer owns the head, so each index has only one
+ *		writer and no locks are needed.  A producer facing a full
+ *		queue, or a consumer facing an empty one, yields until the
+ *		other side catches up.
+ */
+
+# ifndef QUEUE_H
+# define QUEUE_H
+# include <atomic>
+# include <thread>
+
+template<class T, unsigned N>
+class Queue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "size must be a power of two");
+
+    T _slots[N];
+    std::atomic<unsigned> _head, _tail;
+
+public:
+    Queue() : _head(0), _tail(0) {}
+
+    void push(const T &item) {
+	unsigned tail = _tail.load(std::memory_order_relaxed);
+
+	while (tail - _head.load(std::memory_order_acquire) == N)
+	    std::this_thread::yield();
+
+	_slots[tail % N] = item;
+	_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    T pop() {
+	unsigned head = _head.load(std::memory_order_relaxed);
+
+	while (_tail.load(std::memory_order_acquire) == head)
+	    std::this_thread::yield();
+
+	T item = _slots[head % N];
+	_head.store(head + 1, std::memory_order_release);
+	return item;
+    }
+};
+
+# endif /* QUEUE_H */
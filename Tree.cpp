@@ -64,6 +64,20 @@ bool Expression::lvalue() const
 }
 
 
+/*
+ * Function:	Statement::children (accessor)
+ *
+ * Description:	Return the subtrees of this node: nested statements and
+ *		the expressions it contains.  Both are returned by reference,
+ *		so a pass over the tree can replace them.  By default a node
+ *		is a leaf.
+ */
+
+void Statement::children(Substatements &stmts, Subexpressions &exprs)
+{
+}
+
+
 /*
  * Function:	String::String (constructor)
  *
@@ -192,6 +206,31 @@ Call::Call(const Symbol *id, const Expressions &args, const Type &type)
 }
 
 
+/*
+ * Function:	Call::symbol (accessor)
+ *
+ * Description:	Return the symbol of the function being called.
+ */
+
+const Symbol *Call::symbol() const
+{
+    return _id;
+}
+
+
+/*
+ * Function:	Call::children (accessor)
+ *
+ * Description:	Return the subtrees of this function call expression.
+ */
+
+void Call::children(Substatements &stmts, Subexpressions &exprs)
+{
+    for (unsigned i = 0; i < _args.size(); i ++)
+	exprs.push_back(&_args[i]);
+}
+
+
 /*
  * Function:	Field::Field (constructor)
  *
@@ -205,6 +244,30 @@ Field::Field(Expression *expr, Identifier *id, const Type &type)
 }
 
 
+/*
+ * Function:	Field::id (accessor)
+ *
+ * Description:	Return the identifier of the field being referenced.
+ */
+
+Identifier *Field::id() const
+{
+    return _id;
+}
+
+
+/*
+ * Function:	Field::children (accessor)
+ *
+ * Description:	Return the subtrees of this field reference expression.
+ */
+
+void Field::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+}
+
+
 /*
  * Function:	Not::Not (constructor)
  *
@@ -217,6 +280,18 @@ Not::Not(Expression *expr, const Type &type)
 }
 
 
+/*
+ * Function:	Not::children (accessor)
+ *
+ * Description:	Return the subtrees of this logical negation expression.
+ */
+
+void Not::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+}
+
+
 /*
  * Function:	Negate::Negate (constructor)
  *
@@ -229,6 +304,18 @@ Negate::Negate(Expression *expr, const Type &type)
 }
 
 
+/*
+ * Function:	Negate::children (accessor)
+ *
+ * Description:	Return the subtrees of this arithmetic negation expression.
+ */
+
+void Negate::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+}
+
+
 /*
  * Function:	Dereference::Dereference (constructor)
  *
@@ -242,6 +329,18 @@ Dereference::Dereference(Expression *expr, const Type &type)
 }
 
 
+/*
+ * Function:	Dereference::children (accessor)
+ *
+ * Description:	Return the subtrees of this dereference expression.
+ */
+
+void Dereference::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+}
+
+
 /*
  * Function:	Address::Address (constructor)
  *
@@ -254,6 +353,18 @@ Address::Address(Expression *expr, const Type &type)
 }
 
 
+/*
+ * Function:	Address::children (accessor)
+ *
+ * Description:	Return the subtrees of this address expression.
+ */
+
+void Address::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+}
+
+
 /*
  * Function:	Cast::Cast (constructor)
  *
@@ -266,6 +377,45 @@ Cast::Cast(const Type &type, Expression *expr)
 }
 
 
+/*
+ * Function:	Cast::children (accessor)
+ *
+ * Description:	Return the subtrees of this cast expression.
+ */
+
+void Cast::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+}
+
+
+/*
+ * Function:	Reuse::Reuse (constructor)
+ *
+ * Description:	Initialize a reuse of the value of an expression that is
+ *		generated elsewhere, ahead of this one.  The optimizer
+ *		creates these when it moves or shares a computation.  The
+ *		expression is not a subtree of this node.
+ */
+
+Reuse::Reuse(Expression *expr)
+    : Expression(expr->type()), _expr(expr)
+{
+}
+
+
+/*
+ * Function:	Reuse::expr (accessor)
+ *
+ * Description:	Return the expression whose value is reused.
+ */
+
+Expression *Reuse::expr() const
+{
+    return _expr;
+}
+
+
 /*
  * Function:	Multiply::Multiply (constructor)
  *
@@ -278,6 +428,19 @@ Multiply::Multiply(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	Multiply::children (accessor)
+ *
+ * Description:	Return the subtrees of this multiplication expression.
+ */
+
+void Multiply::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	Divide::Divide (constructor)
  *
@@ -290,6 +453,19 @@ Divide::Divide(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	Divide::children (accessor)
+ *
+ * Description:	Return the subtrees of this division expression.
+ */
+
+void Divide::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	Remainder::Remainder (constructor)
  *
@@ -302,6 +478,19 @@ Remainder::Remainder(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	Remainder::children (accessor)
+ *
+ * Description:	Return the subtrees of this remainder expression.
+ */
+
+void Remainder::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	Add::Add (constructor)
  *
@@ -314,6 +503,19 @@ Add::Add(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	Add::children (accessor)
+ *
+ * Description:	Return the subtrees of this addition expression.
+ */
+
+void Add::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	Subtract::Subtract (constructor)
  *
@@ -326,6 +528,19 @@ Subtract::Subtract(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	Subtract::children (accessor)
+ *
+ * Description:	Return the subtrees of this subtraction expression.
+ */
+
+void Subtract::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	LessThan::LessThan (constructor)
  *
@@ -338,6 +553,19 @@ LessThan::LessThan(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	LessThan::children (accessor)
+ *
+ * Description:	Return the subtrees of this less-than expression.
+ */
+
+void LessThan::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	GreaterThan
  *
@@ -350,6 +578,19 @@ GreaterThan::GreaterThan(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	GreaterThan::children (accessor)
+ *
+ * Description:	Return the subtrees of this greater-than expression.
+ */
+
+void GreaterThan::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	LessOrEqual
  *
@@ -362,6 +603,19 @@ LessOrEqual::LessOrEqual(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	LessOrEqual::children (accessor)
+ *
+ * Description:	Return the subtrees of this less-than-or-equal expression.
+ */
+
+void LessOrEqual::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	GreaterOrEqual
  *
@@ -374,6 +628,19 @@ GreaterOrEqual::GreaterOrEqual(Expression *left, Expression *right, const Type &
 }
 
 
+/*
+ * Function:	GreaterOrEqual::children (accessor)
+ *
+ * Description:	Return the subtrees of this greater-than-or-equal expression.
+ */
+
+void GreaterOrEqual::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	Equal::Equal (constructor)
  *
@@ -386,6 +653,19 @@ Equal::Equal(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	Equal::children (accessor)
+ *
+ * Description:	Return the subtrees of this equality expression.
+ */
+
+void Equal::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	NotEqual::NotEqual (constructor)
  *
@@ -398,6 +678,19 @@ NotEqual::NotEqual(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	NotEqual::children (accessor)
+ *
+ * Description:	Return the subtrees of this inequality expression.
+ */
+
+void NotEqual::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	LogicalAnd::LogicalAnd (constructor)
  *
@@ -410,6 +703,19 @@ LogicalAnd::LogicalAnd(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	LogicalAnd::children (accessor)
+ *
+ * Description:	Return the subtrees of this logical-and expression.
+ */
+
+void LogicalAnd::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	LogicalOr::LogicalOr (constructor)
  *
@@ -422,6 +728,19 @@ LogicalOr::LogicalOr(Expression *left, Expression *right, const Type &type)
 }
 
 
+/*
+ * Function:	LogicalOr::children (accessor)
+ *
+ * Description:	Return the subtrees of this logical-or expression.
+ */
+
+void LogicalOr::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	Assignment::Assignment (constructor)
  *
@@ -434,6 +753,19 @@ Assignment::Assignment(Expression *left, Expression *right)
 }
 
 
+/*
+ * Function:	Assignment::children (accessor)
+ *
+ * Description:	Return the subtrees of this assignment statement.
+ */
+
+void Assignment::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_left);
+    exprs.push_back(&_right);
+}
+
+
 /*
  * Function:	Return::Return (constructor)
  *
@@ -446,6 +778,18 @@ Return::Return(Expression *expr)
 }
 
 
+/*
+ * Function:	Return::children (accessor)
+ *
+ * Description:	Return the subtrees of this return statement.
+ */
+
+void Return::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+}
+
+
 /*
  * Function:	Block::Block (constructor)
  *
@@ -470,6 +814,19 @@ Scope *Block::declarations() const
 }
 
 
+/*
+ * Function:	Block::children (accessor)
+ *
+ * Description:	Return the subtrees of this block statement.
+ */
+
+void Block::children(Substatements &stmts, Subexpressions &exprs)
+{
+    for (unsigned i = 0; i < _stmts.size(); i ++)
+	stmts.push_back(&_stmts[i]);
+}
+
+
 /*
  * Function:	While::While (constructor)
  *
@@ -482,6 +839,152 @@ While::While(Expression *expr, Statement *stmt)
 }
 
 
+/*
+ * Function:	While::children (accessor)
+ *
+ * Description:	Return the subtrees of this while statement.
+ */
+
+void While::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+    stmts.push_back(&_stmt);
+}
+
+
+/*
+ * Function:	For::For (constructor)
+ *
+ * Description:	Initialize a for statement.  Any of the initialization,
+ *		test, and increment may be missing.
+ */
+
+For::For(Statement *init, Expression *expr, Statement *incr, Statement *stmt)
+    : _init(init), _expr(expr), _incr(incr), _stmt(stmt)
+{
+}
+
+
+/*
+ * Function:	For::init (accessor)
+ *
+ * Description:	Return the initialization of this for statement, or null
+ *		if it has none.
+ */
+
+Statement *For::init() const
+{
+    return _init;
+}
+
+
+/*
+ * Function:	For::children (accessor)
+ *
+ * Description:	Return the subtrees of this for statement.
+ */
+
+void For::children(Substatements &stmts, Subexpressions &exprs)
+{
+    if (_init != nullptr)
+	stmts.push_back(&_init);
+
+    if (_expr != nullptr)
+	exprs.push_back(&_expr);
+
+    stmts.push_back(&_stmt);
+
+    if (_incr != nullptr)
+	stmts.push_back(&_incr);
+}
+
+
+/*
+ * Function:	Switch::Switch (constructor)
+ *
+ * Description:	Initialize a switch statement.  The case labels are
+ *		statements within the body, but we also keep a list of them
+ *		so that the dispatch can be generated up front.
+ */
+
+Switch::Switch(Expression *expr, Statement *stmt, const Cases &cases)
+    : _expr(expr), _stmt(stmt), _cases(cases)
+{
+}
+
+
+/*
+ * Function:	Switch::children (accessor)
+ *
+ * Description:	Return the subtrees of this switch statement.
+ */
+
+void Switch::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+    stmts.push_back(&_stmt);
+}
+
+
+/*
+ * Function:	Case::Case (constructor)
+ *
+ * Description:	Initialize a case label with the given value.
+ */
+
+Case::Case(long value)
+    : _value(value), _isDefault(false)
+{
+}
+
+
+/*
+ * Function:	Case::Case (constructor)
+ *
+ * Description:	Initialize a default label.
+ */
+
+Case::Case()
+    : _value(0), _isDefault(true)
+{
+}
+
+
+/*
+ * Function:	Case::value (accessor)
+ *
+ * Description:	Return the value of this case label.
+ */
+
+long Case::value() const
+{
+    return _value;
+}
+
+
+/*
+ * Function:	Case::isDefault (accessor)
+ *
+ * Description:	Return whether this is the default label.
+ */
+
+bool Case::isDefault() const
+{
+    return _isDefault;
+}
+
+
+/*
+ * Function:	Break::Break (constructor)
+ *
+ * Description:	Initialize a break statement.
+ */
+
+Break::Break()
+{
+}
+
+
 /*
  * Function:	If::If (constructor)
  *
@@ -494,6 +997,22 @@ If::If(Expression *expr, Statement *thenStmt, Statement *elseStmt)
 }
 
 
+/*
+ * Function:	If::children (accessor)
+ *
+ * Description:	Return the subtrees of this if-then or if-then-else statement.
+ */
+
+void If::children(Substatements &stmts, Subexpressions &exprs)
+{
+    exprs.push_back(&_expr);
+    stmts.push_back(&_thenStmt);
+
+    if (_elseStmt != nullptr)
+	stmts.push_back(&_elseStmt);
+}
+
+
 /*
  * Function:	Function::Function (constructor)
  *
@@ -504,3 +1023,27 @@ Function::Function(const Symbol *id, Block *body)
     : _id(id), _body(body)
 {
 }
+
+
+/*
+ * Function:	Function::symbol (accessor)
+ *
+ * Description:	Return the symbol of this function.
+ */
+
+const Symbol *Function::symbol() const
+{
+    return _id;
+}
+
+
+/*
+ * Function:	Function::body (accessor)
+ *
+ * Description:	Return the body of this function.
+ */
+
+Block *Function::body() const
+{
+    return _body;
+}
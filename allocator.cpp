@@ -9,7 +9,7 @@
  *		- computing the alignment of types
  *		- computing the size of a structure type
  *		- maintaining minimum offset in nested blocks
- *		- allocation within while and if-then-else statements
+ *		- allocation within while, for, switch, and if-then-else statements
  */
 
 # include <cassert>
@@ -18,6 +18,7 @@
 # include "machine.h"
 # include "tokens.h"
 # include "Tree.h"
+# include "timing.h"
 
 using namespace std;
 
@@ -30,6 +31,8 @@ using namespace std;
 
 unsigned Type::size() const
 {
+    TIME("Type::size");
+
     Symbols symbols;
     unsigned count, size, align;
 
@@ -48,7 +51,9 @@ unsigned Type::size() const
 
 
     /* The size of a structure is the size of all of its fields, but with
-       each field aligned and the entire structure aligned as well. */
+       each field aligned and the entire structure aligned as well.  The
+       field offsets are set when the structure is defined, and only read
+       afterwards, since functions may be generated in parallel. */
 
     size = 0;
     symbols = getFields(_specifier);
@@ -59,7 +64,9 @@ unsigned Type::size() const
 	if (size % align != 0)
 	    size += (align - size % align);
 
-	symbols[i]->_offset = size;
+	if (symbols[i]->_offset != (int) size)
+	    symbols[i]->_offset = size;
+
 	size += symbols[i]->type().size();
     }
 
@@ -159,6 +166,34 @@ void While::allocate(int &offset) const
 }
 
 
+/*
+ * Function:	For::allocate
+ *
+ * Description:	Allocate storage for this for statement, which
+ *		essentially means allocating storage for variables declared
+ *		as part of its statement.
+ */
+
+void For::allocate(int &offset) const
+{
+    _stmt->allocate(offset);
+}
+
+
+/*
+ * Function:	Switch::allocate
+ *
+ * Description:	Allocate storage for this switch statement, which
+ *		essentially means allocating storage for variables declared
+ *		as part of its statement.
+ */
+
+void Switch::allocate(int &offset) const
+{
+    _stmt->allocate(offset);
+}
+
+
 /*
  * Function:	If::allocate
  *
@@ -187,24 +222,35 @@ void If::allocate(int &offset) const
  *
  * Description:	Allocate storage for this function and return the number of
  *		bytes required.  The parameters are allocated offsets as
- *		well.
+ *		well.  Those passed in registers are stored by the prologue
+ *		at the top of the frame, and the rest are where the caller
+ *		left them.
  */
 
 void Function::allocate(int &offset) const
 {
+    TIME("allocate");
+
     Parameters *params;
     Symbols symbols;
+    unsigned i;
 
 
     params = _id->type().parameters();
     symbols = _body->declarations()->symbols();
     offset = PARAM_OFFSET;
 
-    for (unsigned i = 0; i < params->size(); i ++) {
+    for (i = REGISTER_ARGS; i < params->size(); i ++) {
 	symbols[i]->_offset = offset;
 	offset += SIZEOF_ARG;
     }
 
     offset = 0;
+
+    for (i = 0; i < params->size() && i < REGISTER_ARGS; i ++) {
+	offset -= SIZEOF_ARG;
+	symbols[i]->_offset = offset;
+    }
+
     _body->allocate(offset);
 }
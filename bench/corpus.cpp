@@ -0,0 +1,368 @@
+/*
+ * File:	corpus.cpp
+ *
+ * Description:	This file contains the main program for generating a
+ *		synthetic Simple C program of a given shape, for measuring
+ *		the throughput of the compiler.  The program is written to
+ *		the standard output, and the same options and seed always
+ *		give the same program.
+ *
+ *		usage: corpus [options]
+ *
+ *		-f N	functions (default 100)
+ *		-g N	global variables (default 50)
+ *		-s N	structure definitions (default 10)
+ *		-m N	fields in each structure (default 6)
+ *		-d N	nesting depth of statements (default 3)
+ *		-e N	operators in each expression (default 4)
+ *		-b N	statements in each block (default 4)
+ *		-r N	seed of the generator (default 1)
+ *
+ *		Every structure after the first contains the one before
+ *		it, so that the layouts nest.  Each block holds one if,
+ *		while, or for statement with a block of its own until the
+ *		depth is reached; the two arms of an if double the
+ *		statements at each level.  Each function takes a
+ *		pointer to a structure and declares locals in each nested
+ *		block, so that the scopes are exercised, and calls only the
+ *		functions defined before it.
+ */
+
+# include <string>
+# include <cstdlib>
+# include <iostream>
+# include <algorithm>
+# include <unistd.h>
+
+using namespace std;
+
+static unsigned functions = 100, globals = 50, structs = 10, fields = 6;
+static unsigned depth = 3, operators = 4, statements = 4;
+static unsigned long long seed = 1;
+
+static const char *ops[] = {
+    "+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=", "&&", "||"
+};
+
+
+/*
+ * Function:	choose
+ *
+ * Description:	Return a pseudo-random number less than N.  The generator
+ *		is our own so that the programs are the same everywhere.
+ */
+
+static unsigned choose(unsigned n)
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (seed >> 33) % n;
+}
+
+
+/*
+ * Function:	field
+ *
+ * Description:	Return the type of field I of a structure.  The first two
+ *		fields are always an int and a char.
+ */
+
+static string field(unsigned i)
+{
+    static const char *types[] = { "int ", "char ", "int *" };
+
+    return types[i % 3];
+}
+
+
+/*
+ * Function:	writeStructures
+ *
+ * Description:	Write the structure definitions.
+ */
+
+static void writeStructures()
+{
+    for (unsigned i = 0; i < structs; i ++) {
+	cout << "struct s" << i << " {" << endl;
+
+	for (unsigned j = 0; j < max(fields, 2u); j ++)
+	    cout << "    " << field(j) << "f" << j << ";" << endl;
+
+	if (i > 0)
+	    cout << "    struct s" << i - 1 << " in;" << endl;
+
+	cout << "    int a[" << 2 + i % 5 << "];" << endl;
+	cout << "};" << endl << endl;
+    }
+}
+
+
+/*
+ * Function:	writeGlobals
+ *
+ * Description:	Write the global variables, which are ints, arrays, char
+ *		pointers, and structures in turn.
+ */
+
+static void writeGlobals()
+{
+    for (unsigned i = 0; i < globals; i ++)
+	switch (i % 4) {
+	case 0:
+	    cout << "int g" << i << ";" << endl;
+	    break;
+
+	case 1:
+	    cout << "int g" << i << "[" << 4 + i % 13 << "];" << endl;
+	    break;
+
+	case 2:
+	    cout << "char *g" << i << ";" << endl;
+	    break;
+
+	default:
+	    if (structs > 0)
+		cout << "struct s" << i % structs << " g" << i << ";" << endl;
+	    else
+		cout << "int g" << i << ";" << endl;
+	}
+
+    cout << endl;
+}
+
+
+/*
+ * Function:	operand
+ *
+ * Description:	Write an int operand of function F: a parameter, a local
+ *		of an enclosing block, a global, a field reached through
+ *		the structure parameter, or a number.
+ */
+
+static void operand(ostream &out, unsigned f, unsigned level)
+{
+    unsigned g;
+
+
+    switch (choose(6)) {
+    case 0:
+	out << (choose(2) ? "a" : "b");
+	break;
+
+    case 1:
+	out << "x" << choose(level + 1);
+	break;
+
+    case 2:
+	if (globals == 0 || (g = choose(globals)) % 4 != 0)
+	    out << "a";
+	else
+	    out << "g" << g;
+	break;
+
+    case 3:
+	if (structs == 0)
+	    out << "b";
+	else if (f % structs > 0 && choose(2))
+	    out << "p->in.f0";
+	else
+	    out << "p->f" << 3 * choose((max(fields, 2u) + 2) / 3);
+	break;
+
+    case 4:
+	if (structs == 0)
+	    out << "a";
+	else
+	    out << "p->a[" << choose(2) << "]";
+	break;
+
+    default:
+	out << 1 + choose(100);
+    }
+}
+
+
+/*
+ * Function:	expression
+ *
+ * Description:	Write an expression with up to N operators.  Division
+ *		and remainder only ever divide by a nonzero number.  A
+ *		function may be called if it takes the same kind of
+ *		structure as function F.
+ */
+
+static void expression(ostream &out, unsigned n, unsigned f, unsigned level)
+{
+    unsigned left, op, callable;
+
+
+    if (n == 0) {
+	callable = (structs > 0 ? f / structs : f);
+
+	if (callable > 0 && choose(8) == 0) {
+	    if (structs > 0)
+		out << "f" << f % structs + structs * choose(callable) << "(a, b, p)";
+	    else
+		out << "f" << choose(callable) << "(a, b)";
+	} else
+	    operand(out, f, level);
+
+	return;
+    }
+
+    left = choose(n);
+    op = choose(sizeof(ops) / sizeof(ops[0]));
+    out << "(";
+    expression(out, left, f, level);
+    out << " " << ops[op] << " ";
+
+    if (op == 3 || op == 4)
+	out << 1 + choose(9);
+    else
+	expression(out, n - left - 1, f, level);
+
+    out << ")";
+}
+
+
+/*
+ * Function:	block
+ *
+ * Description:	Write a block of statements nested LEVEL deep, which
+ *		declares a local of its own.
+ */
+
+static void block(unsigned f, unsigned level)
+{
+    string indent(4 * level, ' ');
+    unsigned compound;
+
+
+    cout << indent << "{" << endl;
+    cout << indent << "    int x" << level << ";" << endl;
+    cout << indent << "    x" << level << " = ";
+    expression(cout, operators, f, level - 1);
+    cout << ";" << endl;
+
+    compound = level < depth ? choose(statements) : statements;
+
+    for (unsigned i = 0; i < statements; i ++) {
+	if (i != compound) {
+	    cout << indent << "    x" << choose(level + 1) << " = ";
+	    expression(cout, operators, f, level);
+	    cout << ";" << endl;
+	    continue;
+	}
+
+	switch (choose(3)) {
+	case 0:
+	    cout << indent << "    if (";
+	    expression(cout, operators, f, level);
+	    cout << ")" << endl;
+	    block(f, level + 1);
+	    cout << indent << "    else" << endl;
+	    block(f, level + 1);
+	    break;
+
+	case 1:
+	    cout << indent << "    while (x" << level << " < ";
+	    expression(cout, 0, f, level);
+	    cout << ")" << endl;
+	    block(f, level + 1);
+	    break;
+
+	default:
+	    cout << indent << "    for (x0 = 0; x0 < ";
+	    expression(cout, 0, f, level);
+	    cout << "; x0 = x0 + 1)" << endl;
+	    block(f, level + 1);
+	}
+    }
+
+    cout << indent << "}" << endl;
+}
+
+
+/*
+ * Function:	writeFunctions
+ *
+ * Description:	Write the function definitions, followed by main.
+ */
+
+static void writeFunctions()
+{
+    for (unsigned f = 0; f < functions; f ++) {
+	cout << "int f" << f << "(int a, int b";
+
+	if (structs > 0)
+	    cout << ", struct s" << f % structs << " *p";
+
+	cout << ")" << endl << "{" << endl;
+	cout << "    int x0;" << endl;
+	cout << "    x0 = a;" << endl;
+	block(f, 1);
+	cout << "    return ";
+	expression(cout, operators, f, 0);
+	cout << ";" << endl << "}" << endl << endl;
+    }
+
+    cout << "int main(void)" << endl << "{" << endl;
+    cout << "    return 0;" << endl << "}" << endl;
+}
+
+
+/*
+ * Function:	number
+ *
+ * Description:	Return the number given as the argument of an option.
+ */
+
+static unsigned number(const char *arg)
+{
+    char *end;
+    unsigned long n = strtoul(arg, &end, 10);
+
+
+    if (*end != '\0') {
+	cerr << "corpus: bad number " << arg << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    return n;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Parse the options and write the program.
+ */
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+
+    while ((opt = getopt(argc, argv, "f:g:s:m:d:e:b:r:")) != -1)
+	switch (opt) {
+	case 'f': functions = number(optarg); break;
+	case 'g': globals = number(optarg); break;
+	case 's': structs = number(optarg); break;
+	case 'm': fields = number(optarg); break;
+	case 'd': depth = number(optarg); break;
+	case 'e': operators = number(optarg); break;
+	case 'b': statements = max(number(optarg), 1u); break;
+	case 'r': seed = number(optarg); break;
+
+	default:
+	    cerr << "usage: corpus [-f functions] [-g globals] [-s structs]";
+	    cerr << " [-m fields] [-d depth] [-e operators] [-b statements]";
+	    cerr << " [-r seed]" << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+    writeStructures();
+    writeGlobals();
+    writeFunctions();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+# File:		insncount.sh
+#
+# Description:	Count the instructions scc emits per statement kind.  For
+#		each kind, a function containing the statement repeated N
+#		times is compiled, the instructions of an empty function
+#		are subtracted, and the result is divided by N.
+#
+#		usage: insncount.sh [scc] [repetitions]
+#
+
+SCC=${1:-./scc}
+N=${2:-100}
+TMP=${TMPDIR:-/tmp}/insncount.$$
+
+trap 'rm -f $TMP.c $TMP.s' 0
+
+# program BODY: write a test program whose function repeats BODY N times
+
+program()
+{
+    echo 'struct s { int a; char b; };'
+    echo 'int f();'
+    echo 'int g(void)'
+    echo '{'
+    echo '    int x, y, *p, a[10];'
+    echo '    char c, *q;'
+    echo '    struct s r, *t;'
+    i=0
+    while [ $i -lt $1 ]; do
+	echo "    $2"
+	i=$((i + 1))
+    done
+    echo '    return 0;'
+    echo '}'
+}
+
+# count REPS BODY: print the number of instructions emitted
+
+count()
+{
+    program "$1" "$2" > $TMP.c
+    $SCC < $TMP.c > $TMP.s 2> /dev/null || exit 1
+    awk '/^\t[a-z]/ && !/^\t\./ { n ++ } END { print n + 0 }' $TMP.s
+}
+
+base=$(count 0 "")
+
+printf "%-28s %s\n" "statement" "insns/stmt"
+
+while IFS='|' read kind body; do
+    total=$(count $N "$body")
+    printf "%-28s %s\n" "$kind" \
+	$(echo "$total $base $N" | awk '{ printf "%.2f", ($1 - $2) / $3 }')
+done <<'KINDS'
+assign-immediate|x = 5;
+assign-char-immediate|c = 'a';
+assign-variable|x = y;
+assign-char-variable|c = x;
+assign-indirect-immediate|*p = 5;
+assign-indirect-variable|*p = y;
+assign-array-immediate|a[3] = 7;
+assign-field-immediate|r.a = 1;
+assign-arrow-variable|t->b = c;
+call-immediate|f(1, 2, 3);
+call-variable|f(x, y, c);
+expression|x + y;
+if|if (x) x = 0;
+if-else|if (x < y) x = 0; else y = 1;
+while|while (x) x = 0;
+KINDS
@@ -0,0 +1,32 @@
+/*
+ * Sum an array of integers over and over.
+ */
+
+int a[10000];
+
+int sum(int *p, int n)
+{
+    int i, s;
+
+    s = 0;
+
+    for (i = 0; i < n; i = i + 1)
+	s = s + p[i];
+
+    return s;
+}
+
+int main(void)
+{
+    int i, r, total;
+
+    for (i = 0; i < 10000; i = i + 1)
+	a[i] = i % 97 - 48;
+
+    total = 0;
+
+    for (r = 0; r < 10000; r = r + 1)
+	total = (total + sum(a, 10000) + r) % 1000003;
+
+    return total != 34862;
+}
@@ -0,0 +1,50 @@
+/*
+ * Sum an array scaled by a factor with Duff's device, which jumps into
+ * the middle of an unrolled loop through the cases of a switch, so
+ * nothing computed before the loop may be relied on inside it.
+ */
+
+int values[1000];
+
+int scaled(int *a, int count, int k)
+{
+    int n, s;
+
+    s = 0;
+    n = (count + 3) / 4;
+
+    switch (count % 4) {
+    case 0:
+	while (n > 0) {
+	    s = s + *a * (k * 3 + k / 7);
+	    a = a + 1;
+    case 3:
+	    s = s + *a * (k * 3 + k / 7);
+	    a = a + 1;
+    case 2:
+	    s = s + *a * (k * 3 + k / 7);
+	    a = a + 1;
+    case 1:
+	    s = s + *a * (k * 3 + k / 7);
+	    a = a + 1;
+	    n = n - 1;
+	}
+    }
+
+    return s;
+}
+
+int main(void)
+{
+    int i, r, total;
+
+    for (i = 0; i < 1000; i = i + 1)
+	values[i] = i % 13 - 6;
+
+    total = 0;
+
+    for (r = 0; r < 50000; r = r + 1)
+	total = (total + scaled(values, r % 1000, r % 9 + 1)) % 1000003;
+
+    return total != -739464;
+}
@@ -0,0 +1,17 @@
+/*
+ * Compute Fibonacci numbers by naive recursion, which is mostly calls
+ * and returns.
+ */
+
+int fib(int n)
+{
+    if (n < 2)
+	return n;
+
+    return fib(n - 1) + fib(n - 2);
+}
+
+int main(void)
+{
+    return fib(35) != 9227465;
+}
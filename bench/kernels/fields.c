@@ -0,0 +1,61 @@
+/*
+ * Update the fields of an array of structures, as in a particle
+ * simulation, reading and writing both int and char fields.
+ */
+
+struct particle {
+    int x, y;
+    int dx, dy;
+    char alive;
+};
+
+struct particle particles[500];
+
+int step(struct particle *p, int n)
+{
+    int i, live;
+
+    live = 0;
+
+    for (i = 0; i < n; i = i + 1) {
+	if (p->alive) {
+	    p->x = p->x + p->dx;
+	    p->y = p->y + p->dy;
+
+	    if (p->x < 0 || p->x > 10000)
+		p->dx = -p->dx;
+
+	    if (p->y < 0 || p->y > 10000)
+		p->dy = -p->dy;
+
+	    live = live + 1;
+	}
+
+	p = p + 1;
+    }
+
+    return live;
+}
+
+int main(void)
+{
+    int i, r, total;
+
+    for (i = 0; i < 500; i = i + 1) {
+	particles[i].x = i * 20;
+	particles[i].y = 10000 - i * 20;
+	particles[i].dx = i % 7 - 3;
+	particles[i].dy = i % 5 - 2;
+	particles[i].alive = i % 10 != 0;
+    }
+
+    total = 0;
+
+    for (r = 0; r < 50000; r = r + 1)
+	total = total + step(particles, 500);
+
+    for (i = 0; i < 500; i = i + 1)
+	total = (total + particles[i].x + particles[i].y) % 1000003;
+
+    return total != 492443;
+}
@@ -0,0 +1,57 @@
+/*
+ * Traverse a linked list of structures whose nodes are scattered through
+ * an array, so that each step follows a pointer to a distant node.
+ */
+
+struct node {
+    int value;
+    struct node *next;
+};
+
+struct node nodes[4096];
+
+int build(int n)
+{
+    int i, j, k;
+
+    i = 0;
+    j = 0;
+
+    while (i < n) {
+	k = (j + 1597) % n;
+	nodes[j].value = i;
+	nodes[j].next = &nodes[k];
+	j = k;
+	i = i + 1;
+    }
+
+    return 0;
+}
+
+int traverse(struct node *p, int n)
+{
+    int sum;
+
+    sum = 0;
+
+    while (n > 0) {
+	sum = sum + p->value;
+	p = p->next;
+	n = n - 1;
+    }
+
+    return sum;
+}
+
+int main(void)
+{
+    int r, total;
+
+    build(4096);
+    total = 0;
+
+    for (r = 0; r < 30000; r = r + 1)
+	total = (total + traverse(&nodes[r % 4096], 4096)) % 1000003;
+
+    return total != 45212;
+}
@@ -0,0 +1,50 @@
+/*
+ * Scan a string with a character pointer, counting the occurrences of
+ * a character and the length of the string.
+ */
+
+char buf[4096];
+
+int count(char *s, char c)
+{
+    int n;
+
+    n = 0;
+
+    while (*s != 0) {
+	if (*s == c)
+	    n = n + 1;
+
+	s = s + 1;
+    }
+
+    return n;
+}
+
+int length(char *s)
+{
+    char *p;
+
+    p = s;
+
+    while (*p)
+	p = p + 1;
+
+    return p - s;
+}
+
+int main(void)
+{
+    int i, r, total;
+
+    for (i = 0; i < 4095; i = i + 1)
+	buf[i] = 'a' + i * 7 % 26;
+
+    buf[4095] = 0;
+    total = 0;
+
+    for (r = 0; r < 10000; r = r + 1)
+	total = (total + count(buf, 'a' + r % 26) + length(buf + r % 4095)) % 1000003;
+
+    return total != 122853;
+}
@@ -0,0 +1,100 @@
+/*
+ * File:	measure.cpp
+ *
+ * Description:	This file contains the main program for measuring a run of
+ *		the compiler.  The command is run the given number of times
+ *		with its standard input read from a file and its output
+ *		discarded, so a failure is only seen in its exit status.
+ *		The shortest elapsed time in seconds and the largest
+ *		resident set in kilobytes are then written on one line.
+ *
+ *		usage: measure runs file command [arguments]
+ */
+
+# include <cstdio>
+# include <cstdlib>
+# include <iostream>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/time.h>
+# include <sys/wait.h>
+# include <sys/resource.h>
+
+using namespace std;
+
+
+/*
+ * Function:	run
+ *
+ * Description:	Run the command once, returning its elapsed time and peak
+ *		resident set.  False is returned if the command failed.
+ */
+
+static bool run(const char *file, char *argv[], double &seconds, long &kilobytes)
+{
+    struct timeval start, end;
+    struct rusage usage;
+    int status, fd;
+    pid_t pid;
+
+
+    gettimeofday(&start, nullptr);
+
+    if ((pid = fork()) == 0) {
+	if ((fd = open(file, O_RDONLY)) < 0 || dup2(fd, 0) < 0) {
+	    perror(file);
+	    _exit(EXIT_FAILURE);
+	}
+
+	if ((fd = open("/dev/null", O_WRONLY)) < 0 || dup2(fd, 1) < 0 || dup2(fd, 2) < 0)
+	    _exit(EXIT_FAILURE);
+
+	execvp(argv[0], argv);
+	perror(argv[0]);
+	_exit(EXIT_FAILURE);
+    }
+
+    if (pid < 0 || wait4(pid, &status, 0, &usage) < 0)
+	return false;
+
+    gettimeofday(&end, nullptr);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    kilobytes = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Run the command and write the best of its measurements.
+ */
+
+int main(int argc, char *argv[])
+{
+    double best = 0, seconds;
+    long peak = 0, kilobytes;
+    int runs;
+
+
+    if (argc < 4 || (runs = atoi(argv[1])) <= 0) {
+	cerr << "usage: measure runs file command [arguments]" << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < runs; i ++) {
+	if (!run(argv[2], argv + 3, seconds, kilobytes)) {
+	    cerr << "measure: " << argv[3] << " failed on " << argv[2] << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	if (i == 0 || seconds < best)
+	    best = seconds;
+
+	if (kilobytes > peak)
+	    peak = kilobytes;
+    }
+
+    cout << best << " " << peak << endl;
+    return 0;
+}
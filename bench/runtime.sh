@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# File:		runtime.sh
+#
+# Description:	Measure the code generated by scc on the kernels in
+#		bench/kernels.  Each kernel is compiled with scc, then
+#		assembled and linked with the system toolchain, and run.  A
+#		kernel checks its own result and exits with a failure if it
+#		is wrong.  For each kernel, the cycles and instructions
+#		counted by perf (if it is installed) and the best elapsed
+#		time of several runs are reported.  Options for scc may be
+#		given in SCCFLAGS, and the command to assemble and link
+#		into a file in LINK (default gcc -m32 -o).
+#
+#		usage: runtime.sh [scc] [runs] [kernel ...]
+#
+
+SCC=${1:-./scc}
+RUNS=${2:-3}
+BENCH=$(dirname $0)
+LINK=${LINK:-gcc -m32 -o}
+TMP=${TMPDIR:-/tmp}/runtime.$$
+
+trap 'rm -f $TMP $TMP.s $TMP.perf' 0
+[ $# -gt 2 ] && shift 2 && KERNELS="$*"
+KERNELS=${KERNELS:-$(ls $BENCH/kernels/*.c | sed 's,.*/,,; s,\.c$,,')}
+
+# counters: print the cycles and instructions of a run, or - for each if
+# perf cannot count them
+
+counters()
+{
+    if command -v perf > /dev/null 2>&1 &&
+	perf stat -x, -e cycles,instructions -r $RUNS -o $TMP.perf $TMP > /dev/null 2>&1; then
+	awk -F, '
+	    $3 ~ /^cycles/ && $1 ~ /^[0-9]/ { cycles = $1 }
+	    $3 ~ /^instructions/ && $1 ~ /^[0-9]/ { insns = $1 }
+	    END { print (cycles != "" ? cycles : "-"), (insns != "" ? insns : "-") }
+	' $TMP.perf
+    else
+	echo - -
+    fi
+}
+
+failed=0
+printf "%-12s %14s %14s %10s\n" "kernel" "cycles" "instructions" "seconds"
+
+for kernel in $KERNELS; do
+    if ! $SCC $SCCFLAGS < $BENCH/kernels/$kernel.c > $TMP.s 2> /dev/null ||
+	! $LINK $TMP $TMP.s; then
+	echo "runtime.sh: cannot build $kernel" 1>&2
+	failed=1
+	continue
+    fi
+
+    if ! result=$($BENCH/measure $RUNS /dev/null $TMP); then
+	echo "runtime.sh: $kernel failed" 1>&2
+	failed=1
+	continue
+    fi
+
+    set -- $(counters) $result
+    printf "%-12s %14s %14s %10.3f\n" $kernel $1 $2 $3
+done
+
+exit $failed
@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# File:		throughput.sh
+#
+# Description:	Measure the compile throughput of scc on synthetic programs
+#		of several shapes made by the corpus generator.  For each
+#		shape, the lines per second of the best of several runs and
+#		the peak resident set are reported.  If MIN_RATE is set,
+#		the script fails when any shape compiles fewer lines per
+#		second, so it can serve as a regression gate.  Options for
+#		scc may be given in SCCFLAGS.
+#
+#		usage: throughput.sh [scc] [runs] [corpus options]
+#
+#		With corpus options, only a program of that shape is
+#		measured (see corpus.cpp for the options).
+#
+
+SCC=${1:-./scc}
+RUNS=${2:-3}
+BENCH=$(dirname $0)
+TMP=${TMPDIR:-/tmp}/throughput.$$
+
+trap 'rm -f $TMP.c' 0
+[ $# -gt 2 ] && shift 2 && SHAPE="$*"
+
+# measure NAME OPTIONS: measure a program of the shape given by OPTIONS
+
+measure()
+{
+    $BENCH/corpus $2 > $TMP.c || exit 1
+    lines=$(wc -l < $TMP.c)
+    set -- "$1" $($BENCH/measure $RUNS $TMP.c $SCC $SCCFLAGS) || exit 1
+    [ $# -eq 3 ] || exit 1
+
+    echo "$1 $lines $2 $3" | awk '{
+	rate = $3 > 0 ? $2 / $3 : 0
+	printf "%-16s %10d %10.3f %12.0f %10d\n", $1, $2, $3, rate, $4
+    }'
+
+    if [ -n "$MIN_RATE" ]; then
+	echo "$lines $2 $MIN_RATE" | awk '{ exit $1 / $2 < $3 }' || {
+	    echo "throughput.sh: $1 is below $MIN_RATE lines/sec" 1>&2
+	    failed=1
+	}
+    fi
+}
+
+failed=0
+printf "%-16s %10s %10s %12s %10s\n" "shape" "lines" "seconds" "lines/sec" "peak KB"
+
+if [ -n "$SHAPE" ]; then
+    measure custom "$SHAPE"
+else
+    while IFS='|' read name options; do
+	measure $name "$options"
+    done <<'SHAPES'
+small|-f 50 -g 20 -s 4 -m 4 -d 2 -e 3
+wide|-f 2000 -g 500 -s 10 -m 6 -d 1 -e 3
+deep|-f 100 -s 10 -d 7 -e 4
+structs|-f 300 -g 300 -s 40 -m 16 -d 2 -e 3
+expressions|-f 200 -s 10 -d 2 -e 40
+SHAPES
+fi
+
+exit $failed
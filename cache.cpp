@@ -0,0 +1,437 @@
+/*
+ * File:	cache.cpp
+ *
+ * Description:	This file contains the member function definitions for the
+ *		on-disk cache of compiled programs and functions.  The key of a program
+ *		describes everything its assembly depends on: the compiler
+ *		itself, the parameters of the target machine, the options
+ *		that change the code, and the source text.  Each entry is
+ *		a file named by a hash of the key, holding the key followed
+ *		by the assembly, so that a hit is always checked against
+ *		the whole key and two keys with the same hash cannot be
+ *		confused.
+ *
+ *		Entries are written to a temporary file and renamed, so
+ *		that compilers sharing a cache never see a partial entry.
+ *		A hit updates the modification time of its entry, and when
+ *		the cache grows beyond its limit, the entries used least
+ *		recently are removed first.  The counts of hits and misses
+ *		are kept in a file of their own, locked while updated.
+ *		The code of single functions is kept the same way (see
+ *		incremental.cpp).
+ */
+
+# include <atomic>
+# include <vector>
+# include <cstdio>
+# include <cstdlib>
+# include <cstring>
+# include <sstream>
+# include <fstream>
+# include <algorithm>
+# include <fcntl.h>
+# include <dirent.h>
+# include <unistd.h>
+# include <utime.h>
+# include <sys/file.h>
+# include <sys/stat.h>
+# include "cache.h"
+# include "machine.h"
+
+using namespace std;
+
+static const string suffix = ".s";
+static const string statistics = "stats";
+
+struct Entry {
+    string name;
+    time_t used;
+    off_t size;
+};
+
+
+/*
+ * Function:	fnv
+ *
+ * Description:	Return the 64-bit FNV-1a hash of a string, written in hex.
+ */
+
+static string fnv(const string &s)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    char buf[17];
+
+    for (size_t i = 0; i < s.size(); i ++) {
+	h ^= (unsigned char) s[i];
+	h *= 1099511628211ULL;
+    }
+
+    snprintf(buf, sizeof(buf), "%016llx", h);
+    return buf;
+}
+
+
+/*
+ * Function:	readFile
+ *
+ * Description:	Read the whole of a file into a string.
+ */
+
+static bool readFile(const string &path, string &contents)
+{
+    ifstream in(path.c_str(), ios::binary);
+    stringstream buffer;
+
+    if (!in)
+	return false;
+
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+
+/*
+ * Function:	version
+ *
+ * Description:	Return the version of the compiler, which is a hash of its
+ *		own executable, so that any change to the compiler misses
+ *		every entry made by the one before.  Where the executable
+ *		cannot be read, the time it was built is used instead.
+ */
+
+static const string &version()
+{
+    static string result;
+    string contents;
+
+    if (result.empty()) {
+	if (readFile("/proc/self/exe", contents))
+	    result = fnv(contents);
+	else
+	    result = __DATE__ " " __TIME__;
+    }
+
+    return result;
+}
+
+
+/*
+ * Function:	target
+ *
+ * Description:	Return a description of a target machine.
+ */
+
+static string target(const Machine &machine)
+{
+    stringstream out;
+
+    out << machine.name;
+    out << ", char " << machine.sizeofChar << " " << machine.alignofChar;
+    out << ", int " << machine.sizeofInt << " " << machine.alignofInt;
+    out << ", ptr " << machine.sizeofPtr << " " << machine.alignofPtr;
+    out << ", arg " << machine.sizeofArg << " " << machine.paramOffset;
+    out << ", stack " << machine.stackAlignment;
+    out << ", registers " << machine.registerArgs;
+    out << ", prefix '" << global_prefix << "' '" << label_prefix << "'";
+    return out.str();
+}
+
+
+/*
+ * Function:	makeDirectory
+ *
+ * Description:	Create a directory along with any missing parents.
+ */
+
+static void makeDirectory(const string &path)
+{
+    size_t slash = 0;
+
+    while ((slash = path.find('/', slash + 1)) != string::npos)
+	mkdir(path.substr(0, slash).c_str(), 0777);
+
+    mkdir(path.c_str(), 0777);
+}
+
+
+/*
+ * Function:	isEntry
+ *
+ * Description:	Return whether a file in the cache is an entry.
+ */
+
+static bool isEntry(const string &name)
+{
+    return name.size() > suffix.size() &&
+	name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+
+/*
+ * Function:	leastRecent
+ *
+ * Description:	Return whether one entry was used before another.
+ */
+
+static bool leastRecent(const Entry &a, const Entry &b)
+{
+    return a.used < b.used || (a.used == b.used && a.name < b.name);
+}
+
+
+/*
+ * Function:	rate
+ *
+ * Description:	Write a count of hits and misses.
+ */
+
+static void rate(ostream &out, unsigned long hits, unsigned long misses)
+{
+    out << hits << " hits, " << misses << " misses";
+
+    if (hits + misses > 0)
+	out << " (" << 100 * hits / (hits + misses) << "% hit rate)";
+
+    out << endl;
+}
+
+
+/*
+ * Function:	Cache::Cache (constructor)
+ *
+ * Description:	Initialize a cache in the given directory, holding at most
+ *		LIMIT bytes of entries.
+ */
+
+Cache::Cache(const string &directory, unsigned long limit)
+    : _directory(directory), _limit(limit)
+{
+    makeDirectory(_directory);
+}
+
+
+/*
+ * Function:	Cache::path
+ *
+ * Description:	Return the path of a file in the cache.
+ */
+
+string Cache::path(const string &name) const
+{
+    return _directory + "/" + name;
+}
+
+
+/*
+ * Function:	Cache::key
+ *
+ * Description:	Return the key for compiling SOURCE with OPTIONS.  The
+ *		number of jobs and the pipeline do not change the code and
+ *		so are not part of the key.
+ */
+
+string Cache::key(const Options &options, const string &source) const
+{
+    stringstream out;
+    set<string>::const_iterator it;
+
+    out << "scc " << version() << endl;
+    out << "target " << target(*findMachine(options.target)) << endl;
+    out << "options";
+    out << (options.optimize ? " -O" : "");
+    out << " -funroll-loops=" << options.unrollFactor;
+    out << (options.wholeProgram ? " -fwhole-program" : "");
+    out << (options.instrument ? " -finstrument" : "");
+    out << (options.profileFile.empty() ? "" : " -fprofile-use");
+    out << (options.debug ? " -g -fsource-name=" + options.sourceName : "");
+
+    if (options.instrumentFunctions) {
+	out << " -finstrument-functions -fentry-hook=" << options.entryHook;
+	out << " -fexit-hook=" << options.exitHook;
+    }
+
+    for (it = options.exported.begin(); it != options.exported.end(); it ++)
+	out << " -fexport=" << *it;
+
+    out << endl << "source " << source.size() << endl << source;
+    return out.str();
+}
+
+
+/*
+ * Function:	Cache::find
+ *
+ * Description:	Look up the value for a key, and count the hit or miss as
+ *		one for a whole program or for a function.
+ */
+
+bool Cache::find(const string &key, string &value, bool function) const
+{
+    string name = path(fnv(key) + suffix), contents;
+    bool hit;
+
+    hit = readFile(name, contents) && contents.size() >= key.size() &&
+	contents.compare(0, key.size(), key) == 0;
+
+    if (hit) {
+	value = contents.substr(key.size());
+	utime(name.c_str(), nullptr);
+    }
+
+    count(function, hit);
+    return hit;
+}
+
+
+/*
+ * Function:	Cache::insert
+ *
+ * Description:	Enter the value for a key, then make room for it.  The
+ *		value is written to a temporary of its own, numbered within
+ *		the process, so that threads inserting the same key never
+ *		share a file, and is then renamed into place.
+ */
+
+void Cache::insert(const string &key, const string &value) const
+{
+    static atomic<unsigned long> serial(0);
+    string name = fnv(key) + suffix;
+    stringstream temp;
+
+    temp << path("tmp.") << getpid() << "." << serial ++;
+
+    ofstream out(temp.str().c_str(), ios::binary);
+
+    out << key << value;
+    out.close();
+
+    if (!out) {
+	unlink(temp.str().c_str());
+	return;
+    }
+
+    if (rename(temp.str().c_str(), path(name).c_str()) < 0)
+	unlink(temp.str().c_str());
+    else
+	evict(name);
+}
+
+
+/*
+ * Function:	Cache::evict
+ *
+ * Description:	Remove the entries used least recently until the cache
+ *		fits within its limit, keeping the entry just made.
+ */
+
+void Cache::evict(const string &keep) const
+{
+    vector<Entry> entries;
+    unsigned long total = 0;
+    struct dirent *dirent;
+    struct stat info;
+    DIR *dir;
+    Entry e;
+
+
+    if ((dir = opendir(_directory.c_str())) == nullptr)
+	return;
+
+    while ((dirent = readdir(dir)) != nullptr) {
+	e.name = dirent->d_name;
+
+	if (!isEntry(e.name) || stat(path(e.name).c_str(), &info) < 0)
+	    continue;
+
+	e.used = info.st_mtime;
+	e.size = info.st_size;
+	total += e.size;
+
+	if (e.name != keep)
+	    entries.push_back(e);
+    }
+
+    closedir(dir);
+    sort(entries.begin(), entries.end(), leastRecent);
+
+    for (unsigned i = 0; i < entries.size() && total > _limit; i ++)
+	if (unlink(path(entries[i].name).c_str()) == 0)
+	    total -= entries[i].size;
+}
+
+
+/*
+ * Function:	Cache::count
+ *
+ * Description:	Add a hit or miss to the statistics of the cache, which
+ *		count whole programs and single functions separately.
+ */
+
+void Cache::count(bool function, bool hit) const
+{
+    unsigned long counts[4] = {0, 0, 0, 0};
+    char buf[128];
+    ssize_t n;
+    int fd;
+
+
+    if ((fd = open(path(statistics).c_str(), O_RDWR | O_CREAT, 0666)) < 0)
+	return;
+
+    flock(fd, LOCK_EX);
+
+    if ((n = read(fd, buf, sizeof(buf) - 1)) > 0) {
+	buf[n] = '\0';
+	sscanf(buf, "%lu %lu %lu %lu", &counts[0], &counts[1], &counts[2], &counts[3]);
+    }
+
+    counts[2 * function + !hit] ++;
+    n = snprintf(buf, sizeof(buf), "%lu %lu %lu %lu\n", counts[0], counts[1], counts[2], counts[3]);
+
+    if (ftruncate(fd, 0) == 0 && lseek(fd, 0, SEEK_SET) == 0)
+	n = write(fd, buf, n);
+
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+
+/*
+ * Function:	Cache::report
+ *
+ * Description:	Write the statistics of the cache.
+ */
+
+void Cache::report(ostream &out) const
+{
+    unsigned long counts[4] = {0, 0, 0, 0}, entries = 0, total = 0;
+    struct dirent *dirent;
+    struct stat info;
+    string contents;
+    DIR *dir;
+
+
+    if (readFile(path(statistics), contents))
+	sscanf(contents.c_str(), "%lu %lu %lu %lu", &counts[0], &counts[1], &counts[2], &counts[3]);
+
+    if ((dir = opendir(_directory.c_str())) != nullptr) {
+	while ((dirent = readdir(dir)) != nullptr) {
+	    string name = dirent->d_name;
+
+	    if (isEntry(name) && stat(path(name).c_str(), &info) == 0) {
+		entries ++;
+		total += info.st_size;
+	    }
+	}
+
+	closedir(dir);
+    }
+
+    out << "scc: cache " << _directory << ": " << entries << " entries, ";
+    out << total << " of " << _limit << " bytes" << endl;
+    out << "scc: programs: ";
+    rate(out, counts[0], counts[1]);
+    out << "scc: functions: ";
+    rate(out, counts[2], counts[3]);
+}
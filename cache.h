@@ -0,0 +1,31 @@
+/*
+ * File:	cache.h
+ *
+ * Description:	This file contains the class definition for the on-disk
+ *		cache of compiled programs and functions.
+ */
+
+# ifndef CACHE_H
+# define CACHE_H
+# include <string>
+# include <ostream>
+# include "options.h"
+
+class Cache {
+    std::string _directory;
+    unsigned long _limit;
+
+    std::string path(const std::string &name) const;
+    void count(bool function, bool hit) const;
+    void evict(const std::string &keep) const;
+
+public:
+    Cache(const std::string &directory, unsigned long limit);
+
+    std::string key(const Options &options, const std::string &source) const;
+    bool find(const std::string &key, std::string &value, bool function = false) const;
+    void insert(const std::string &key, const std::string &value) const;
+    void report(std::ostream &out) const;
+};
+
+# endif /* CACHE_H */
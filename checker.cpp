@@ -8,7 +8,8 @@
  *		- inserting an undeclared symbol with the error type
  */
 
-# include <map>
+# include <mutex>
+# include <vector>
 # include <cassert>
 # include <iostream>
 # include "lexer.h"
@@ -18,12 +19,13 @@
 # include "Symbol.h"
 # include "Scope.h"
 # include "Type.h"
+# include "compiler.h"
+# include "memory.h"
+# include "timing.h"
 
 
 using namespace std;
 
-static map<string,Scope *> fields;
-static Scope *outermost, *toplevel;
 static const Type error, integer("int"), character("char");
 
 static string undeclared = "'%s' undeclared";
@@ -43,6 +45,11 @@ static string invalid_sizeof = "invalid operand in sizeof expression";
 static string invalid_function = "called object is not a function";
 static string invalid_arguments = "invalid arguments to called function";
 static string incomplete_type = "using pointer to incomplete type";
+static string invalid_switch = "invalid type for switch expression";
+static string duplicate_case = "duplicate case value";
+static string duplicate_default = "multiple default labels in one switch";
+static string misplaced_label = "'%s' label not within a switch statement";
+static string misplaced_break = "break statement not within loop or switch";
 
 
 /*
@@ -68,11 +75,11 @@ static Type promote(Expression *&expr)
 {
     if (expr->type().isArray()) {
 	debug("promoting", expr->type(), expr->type().promote());
-	expr = new Address(expr, expr->type().promote());
+	expr = create<Address>(expr, expr->type().promote());
 
     } else if (expr->type() == character) {
 	debug("promoting", character, integer);
-	expr = new Cast(integer, expr);
+	expr = create<Cast>(integer, expr);
     }
 
     return expr->type();
@@ -87,7 +94,7 @@ static Type promote(Expression *&expr)
 
 static bool isIncomplete(const Type &t)
 {
-    return !t.isPointer() && t.isStruct() && fields.count(t.specifier()) == 0;
+    return !t.isPointer() && t.isStruct() && compiler->fields.count(t.specifier()) == 0;
 }
 
 
@@ -117,7 +124,7 @@ static Type checkIfComplete(const string &name, const Type &type)
     if (!type.isStruct() || type.indirection() > 0)
 	return type;
 
-    if (fields.count(type.specifier()) > 0)
+    if (compiler->fields.count(type.specifier()) > 0)
 	return type;
 
     report(incomplete, name);
@@ -149,12 +156,12 @@ static Type checkIfStructure(const string &name, const Type &type)
 
 Scope *openScope()
 {
-    toplevel = new Scope(toplevel);
+    compiler->toplevel = create<Scope>(compiler->toplevel);
 
-    if (outermost == nullptr)
-	outermost = toplevel;
+    if (compiler->outermost == nullptr)
+	compiler->outermost = compiler->toplevel;
 
-    return toplevel;
+    return compiler->toplevel;
 }
 
 
@@ -167,9 +174,9 @@ Scope *openScope()
 
 Scope *closeScope()
 {
-    Scope *old = toplevel;
+    Scope *old = compiler->toplevel;
 
-    toplevel = toplevel->enclosing();
+    compiler->toplevel = compiler->toplevel->enclosing();
     return old;
 }
 
@@ -178,12 +185,16 @@ Scope *closeScope()
  * Function:	getFields
  *
  * Description:	Return the fields associated with the specified structure.
+ *		The code generator may call this while the parser is still
+ *		defining structures, so the table is locked.
  */
 
 Symbols getFields(const string &name)
 {
-    assert(fields.count(name) > 0);
-    return fields[name]->symbols();
+    lock_guard<mutex> lock(compiler->fieldsLock);
+
+    assert(compiler->fields.count(name) > 0);
+    return compiler->fields[name]->symbols();
 }
 
 
@@ -197,12 +208,14 @@ Symbols getFields(const string &name)
 
 void defineStructure(const string &name, Scope *scope)
 {
-    if (fields.count(name) > 0) {
+    if (compiler->fields.count(name) > 0) {
 	report(redefined, name);
-	delete scope;
+	destroy(scope);
     } else
 	{
-		fields[name] = scope;
+		compiler->fieldsLock.lock();
+		compiler->fields[name] = scope;
+		compiler->fieldsLock.unlock();
 		Type t(name);
 		t.size();
 	}
@@ -220,22 +233,22 @@ void defineStructure(const string &name, Scope *scope)
 
 Symbol *defineFunction(const string &name, const Type &type)
 {
-    Symbol *symbol = outermost->find(name);
+    Symbol *symbol = compiler->outermost->find(name);
 
     if (symbol != nullptr) {
 	if (symbol->type().isFunction() && symbol->type().parameters()) {
 	    report(redefined, name);
-	    delete symbol->type().parameters();
+	    destroy(symbol->type().parameters());
 
 	} else if (type != symbol->type())
 	    report(conflicting, name);
 
-	outermost->remove(name);
-	delete symbol;
+	compiler->outermost->remove(name);
+	destroy(symbol);
     }
 
-    symbol = new Symbol(name, checkIfStructure(name, type));
-    outermost->insert(symbol);
+    symbol = create<Symbol>(name, checkIfStructure(name, type));
+    compiler->outermost->insert(symbol);
 
     return symbol;
 }
@@ -251,15 +264,15 @@ Symbol *defineFunction(const string &name, const Type &type)
 
 Symbol *declareFunction(const string &name, const Type &type)
 {
-    Symbol *symbol = outermost->find(name);
+    Symbol *symbol = compiler->outermost->find(name);
 
     if (symbol == nullptr) {
-	symbol = new Symbol(name, checkIfStructure(name, type));
-	outermost->insert(symbol);
+	symbol = create<Symbol>(name, checkIfStructure(name, type));
+	compiler->outermost->insert(symbol);
 
     } else if (type != symbol->type()) {
 	report(conflicting, name);
-	delete type.parameters();
+	destroy(type.parameters());
     }
 
     return symbol;
@@ -290,13 +303,13 @@ Symbol *declareParameter(const string &name, const Type &type)
 
 Symbol *declareVariable(const string &name, const Type &type)
 {
-    Symbol *symbol = toplevel->find(name);
+    Symbol *symbol = compiler->toplevel->find(name);
 
     if (symbol == nullptr) {
-	symbol = new Symbol(name, checkIfComplete(name, type));
-	toplevel->insert(symbol);
+	symbol = create<Symbol>(name, checkIfComplete(name, type));
+	compiler->toplevel->insert(symbol);
 
-    } else if (outermost != toplevel)
+    } else if (compiler->outermost != compiler->toplevel)
 	report(redeclared, name);
 
     else if (type != symbol->type())
@@ -316,12 +329,14 @@ Symbol *declareVariable(const string &name, const Type &type)
 
 Symbol *checkIdentifier(const string &name)
 {
-    Symbol *symbol = toplevel->lookup(name);
+    TIME("check identifiers");
+
+    Symbol *symbol = compiler->toplevel->lookup(name);
 
     if (symbol == nullptr) {
 	report(undeclared, name);
-	symbol = new Symbol(name, error);
-	toplevel->insert(symbol);
+	symbol = create<Symbol>(name, error);
+	compiler->toplevel->insert(symbol);
     }
 
     return symbol;
@@ -338,6 +353,8 @@ Symbol *checkIdentifier(const string &name)
 
 Expression *checkCall(Symbol *id, Expressions &args)
 {
+    TIME("check calls");
+
     const Type &t = id->type();
     Type arg, result = error;
 
@@ -377,7 +394,7 @@ Expression *checkCall(Symbol *id, Expressions &args)
 	}
     }
 
-    return new Call(id, args, result);
+    return create<Call>(id, args, result);
 }
 
 
@@ -391,14 +408,16 @@ Expression *checkCall(Symbol *id, Expressions &args)
 
 Expression *checkArray(Expression *left, Expression *right)
 {
+    TIME("check postfix");
+
     const Type &t1 = promote(left);
     const Type &t2 = promote(right);
     Type result = error;
 
     if (t1.isPointer() && t1.deref().size() > 1)
-	right = new Multiply(right, new Number(t1.deref().size()), integer);
+	right = create<Multiply>(right, create<Number>(t1.deref().size()), integer);
 
-    Expression *expr = new Add(left, right, t1);
+    Expression *expr = create<Add>(left, right, t1);
 
     if (t1 != error && t2 != error) {
 	if (isIncompletePointer(t1))
@@ -409,7 +428,7 @@ Expression *checkArray(Expression *left, Expression *right)
 	    report(invalid_operands, "[]");
     }
 
-    return new Dereference(expr, result);
+    return create<Dereference>(expr, result);
 }
 
 
@@ -426,6 +445,8 @@ Expression *checkArray(Expression *left, Expression *right)
 
 Expression *checkDirectField(Expression *expr, const string &id)
 {
+    TIME("check postfix");
+
     Scope *scope;
     Symbol *symbol = nullptr;
     const Type &t = expr->type();
@@ -441,13 +462,13 @@ Expression *checkDirectField(Expression *expr, const string &id)
 		report(incomplete_type);
 
 	    else {
-		scope = fields[t.specifier()];
+		scope = compiler->fields[t.specifier()];
 		symbol = scope->find(id);
 		t.size();
 
 		if (symbol == nullptr) {
 		    report(invalid_operands, ".");
-		    symbol = new Symbol(id, error);
+		    symbol = create<Symbol>(id, error);
 		    scope->insert(symbol);
 		}
 
@@ -457,9 +478,9 @@ Expression *checkDirectField(Expression *expr, const string &id)
     }
 
     if (symbol == nullptr)
-	symbol = new Symbol("-unknown-", error);
+	symbol = create<Symbol>("-unknown-", error);
 
-    return new Field(expr, new Identifier(symbol), result);
+    return create<Field>(expr, create<Identifier>(symbol), result);
 }
 
 
@@ -474,6 +495,8 @@ Expression *checkDirectField(Expression *expr, const string &id)
 
 Expression *checkIndirectField(Expression *expr, const string &id)
 {
+    TIME("check postfix");
+
     Scope *scope;
     Symbol *symbol = nullptr;
     Type t = expr->type().promote();
@@ -489,13 +512,13 @@ Expression *checkIndirectField(Expression *expr, const string &id)
 		report(incomplete_type);
 
 	    else {
-		scope = fields[t.specifier()];
+		scope = compiler->fields[t.specifier()];
 		symbol = scope->find(id);
 		t = t.deref();
 
 		if (symbol == nullptr) {
 		    report(invalid_operands, "->");
-		    symbol = new Symbol(id, error);
+		    symbol = create<Symbol>(id, error);
 		    scope->insert(symbol);
 		}
 
@@ -505,9 +528,9 @@ Expression *checkIndirectField(Expression *expr, const string &id)
     }
 
     if (symbol == nullptr)
-	symbol = new Symbol("-unknown-", error);
+	symbol = create<Symbol>("-unknown-", error);
 
-    return new Field(new Dereference(expr, t), new Identifier(symbol), result);
+    return create<Field>(create<Dereference>(expr, t), create<Identifier>(symbol), result);
 }
  
 
@@ -520,6 +543,8 @@ Expression *checkIndirectField(Expression *expr, const string &id)
 
 Expression *checkNot(Expression *expr)
 {
+    TIME("check unary");
+
     const Type &t = promote(expr);
     Type result = error;
 
@@ -531,7 +556,7 @@ Expression *checkNot(Expression *expr)
 	    report(invalid_operand, "!");
     }
 
-    return new Not(expr, result);
+    return create<Not>(expr, result);
 }
 
 
@@ -544,6 +569,8 @@ Expression *checkNot(Expression *expr)
 
 Expression *checkNegate(Expression *expr)
 {
+    TIME("check unary");
+
     const Type &t = promote(expr);
     Type result = error;
 
@@ -555,7 +582,7 @@ Expression *checkNegate(Expression *expr)
 	    report(invalid_operand, "-");
     }
 
-    return new Negate(expr, result);
+    return create<Negate>(expr, result);
 }
 
 
@@ -568,6 +595,8 @@ Expression *checkNegate(Expression *expr)
 
 Expression *checkDereference(Expression *expr)
 {
+    TIME("check unary");
+
     const Type &t = promote(expr);
     Type result = error;
 
@@ -581,7 +610,7 @@ Expression *checkDereference(Expression *expr)
 	    report(invalid_operand, "*");
     }
 
-    return new Dereference(expr, result);
+    return create<Dereference>(expr, result);
 }
 
 
@@ -595,6 +624,8 @@ Expression *checkDereference(Expression *expr)
 
 Expression *checkAddress(Expression *expr)
 {
+    TIME("check unary");
+
     const Type &t = expr->type();
     Type result = error;
 
@@ -606,7 +637,7 @@ Expression *checkAddress(Expression *expr)
 	    report(invalid_lvalue);
     }
 
-    return new Address(expr, result);
+    return create<Address>(expr, result);
 }
 
 
@@ -619,11 +650,13 @@ Expression *checkAddress(Expression *expr)
 
 Expression *checkSizeof(const Type &type)
 {
+    TIME("check unary");
+
     if (type != error)
 	if (type.isFunction() || isIncomplete(type))
 	    report(invalid_sizeof);
 
-    return new Number(type.size());
+    return create<Number>(type.size());
 }
 
 
@@ -636,6 +669,8 @@ Expression *checkSizeof(const Type &type)
 
 Expression *checkCast(const Type &type, Expression *expr)
 {
+    TIME("check unary");
+
     const Type &t = promote(expr);
     Type result = error;
 
@@ -647,7 +682,7 @@ Expression *checkCast(const Type &type, Expression *expr)
 	    report(invalid_cast);
     }
 
-    return new Cast(result, expr);
+    return create<Cast>(result, expr);
 }
 
 
@@ -684,8 +719,10 @@ static Type checkMult(Expression *&left, Expression *&right, const string &op)
 
 Expression *checkMultiply(Expression *left, Expression *right)
 {
+    TIME("check arithmetic");
+
     Type t = checkMult(left, right, "*");
-    return new Multiply(left, right, t);
+    return create<Multiply>(left, right, t);
 }
 
 
@@ -697,8 +734,10 @@ Expression *checkMultiply(Expression *left, Expression *right)
 
 Expression *checkDivide(Expression *left, Expression *right)
 {
+    TIME("check arithmetic");
+
     Type t = checkMult(left, right, "/");
-    return new Divide(left, right, t);
+    return create<Divide>(left, right, t);
 }
 
 /*
@@ -709,8 +748,10 @@ Expression *checkDivide(Expression *left, Expression *right)
 
 Expression *checkRemainder(Expression *left, Expression *right)
 {
+    TIME("check arithmetic");
+
     Type t = checkMult(left, right, "%");
-    return new Remainder(left, right, t);
+    return create<Remainder>(left, right, t);
 }
 
 
@@ -725,6 +766,8 @@ Expression *checkRemainder(Expression *left, Expression *right)
 
 Expression *checkAdd(Expression *left, Expression *right)
 {
+    TIME("check arithmetic");
+
     const Type &t1 = promote(left);
     const Type &t2 = promote(right);
     Type result = error;
@@ -739,13 +782,13 @@ Expression *checkAdd(Expression *left, Expression *right)
 
 	else if (t1.isPointer() && t2 == integer) {
 	    if (t1.deref().size() > 1)
-		right = new Multiply(right, new Number(t1.deref().size()), integer);
+		right = create<Multiply>(right, create<Number>(t1.deref().size()), integer);
 
 	    result = t1;
 
 	} else if (t1 == integer && t2.isPointer()) {
 	    if (t2.deref().size() > 1)
-		left = new Multiply(left, new Number(t2.deref().size()), integer);
+		left = create<Multiply>(left, create<Number>(t2.deref().size()), integer);
 
 	    result = t2;
 
@@ -753,7 +796,7 @@ Expression *checkAdd(Expression *left, Expression *right)
 	    report(invalid_operands, "+");
     }
 
-    return new Add(left, right, result);
+    return create<Add>(left, right, result);
 }
 
 
@@ -769,6 +812,8 @@ Expression *checkAdd(Expression *left, Expression *right)
 
 Expression *checkSubtract(Expression *left, Expression *right)
 {
+    TIME("check arithmetic");
+
     Expression *tree;
     const Type &t1 = promote(left);
     const Type &t2 = promote(right);
@@ -788,7 +833,7 @@ Expression *checkSubtract(Expression *left, Expression *right)
 
 	else if (t1.isPointer() && t2 == integer) {
 	    if (t1.deref().size() > 1)
-		right = new Multiply(right, new Number(t1.deref().size()), integer);
+		right = create<Multiply>(right, create<Number>(t1.deref().size()), integer);
 
 	    result = t1;
 
@@ -796,10 +841,10 @@ Expression *checkSubtract(Expression *left, Expression *right)
 	    report(invalid_operands, "-");
     }
 
-    tree = new Subtract(left, right, result);
+    tree = create<Subtract>(left, right, result);
 
     if (t1.isPointer() && t1 == t2 && t1.deref().size() > 1)
-	tree = new Divide(tree, new Number(t1.deref().size()), integer);
+	tree = create<Divide>(tree, create<Number>(t1.deref().size()), integer);
 
     return tree;
 }
@@ -840,8 +885,10 @@ Type checkCompare(Expression *&left, Expression *&right, const string &op)
 
 Expression *checkLessThan(Expression *left, Expression *right)
 {
+    TIME("check comparisons");
+
     Type t = checkCompare(left, right, "<");
-    return new LessThan(left, right, t);
+    return create<LessThan>(left, right, t);
 }
 
 
@@ -853,8 +900,10 @@ Expression *checkLessThan(Expression *left, Expression *right)
 
 Expression *checkGreaterThan(Expression *left, Expression *right)
 {
+    TIME("check comparisons");
+
     Type t = checkCompare(left, right, ">");
-    return new GreaterThan(left, right, t);
+    return create<GreaterThan>(left, right, t);
 }
 
 
@@ -866,8 +915,10 @@ Expression *checkGreaterThan(Expression *left, Expression *right)
 
 Expression *checkLessOrEqual(Expression *left, Expression *right)
 {
+    TIME("check comparisons");
+
     Type t = checkCompare(left, right, "<=");
-    return new LessOrEqual(left, right, t);
+    return create<LessOrEqual>(left, right, t);
 }
 
 
@@ -879,8 +930,10 @@ Expression *checkLessOrEqual(Expression *left, Expression *right)
 
 Expression *checkGreaterOrEqual(Expression *left, Expression *right)
 {
+    TIME("check comparisons");
+
     Type t = checkCompare(left, right, ">=");
-    return new GreaterOrEqual(left, right, t);
+    return create<GreaterOrEqual>(left, right, t);
 }
 
 
@@ -892,8 +945,10 @@ Expression *checkGreaterOrEqual(Expression *left, Expression *right)
 
 Expression *checkEqual(Expression *left, Expression *right)
 {
+    TIME("check comparisons");
+
     Type t = checkCompare(left, right, "==");
-    return new Equal(left, right, t);
+    return create<Equal>(left, right, t);
 }
 
 
@@ -905,8 +960,10 @@ Expression *checkEqual(Expression *left, Expression *right)
 
 Expression *checkNotEqual(Expression *left, Expression *right)
 {
+    TIME("check comparisons");
+
     Type t = checkCompare(left, right, "!=");
-    return new NotEqual(left, right, t);
+    return create<NotEqual>(left, right, t);
 }
 
 
@@ -945,8 +1002,10 @@ Type checkLogical(Expression *&left, Expression *&right, const string &op)
 
 Expression *checkLogicalAnd(Expression *left, Expression *right)
 {
+    TIME("check logical");
+
     Type t = checkLogical(left, right, "&&");
-    return new LogicalAnd(left, right, t);
+    return create<LogicalAnd>(left, right, t);
 }
 
 
@@ -958,8 +1017,10 @@ Expression *checkLogicalAnd(Expression *left, Expression *right)
 
 Expression *checkLogicalOr(Expression *left, Expression *right)
 {
+    TIME("check logical");
+
     Type t = checkLogical(left, right, "||");
-    return new LogicalOr(left, right, t);
+    return create<LogicalOr>(left, right, t);
 }
 
 
@@ -972,6 +1033,8 @@ Expression *checkLogicalOr(Expression *left, Expression *right)
 
 Statement *checkAssignment(Expression *left, Expression *right)
 {
+    TIME("check statements");
+
     const Type &t1 = left->type();
     const Type &t2 = promote(right);
 
@@ -984,7 +1047,7 @@ Statement *checkAssignment(Expression *left, Expression *right)
 	    report(invalid_operands, "=");
     }
 
-    return new Assignment(left, right);
+    return create<Assignment>(left, right);
 }
 
 
@@ -998,6 +1061,8 @@ Statement *checkAssignment(Expression *left, Expression *right)
 
 void checkReturn(Expression *&expr, const Type &type)
 {
+    TIME("check statements");
+
     const Type &t = promote(expr);
 
     if (t != error && !t.isCompatibleWith(type))
@@ -1015,8 +1080,156 @@ void checkReturn(Expression *&expr, const Type &type)
 
 void checkTest(Expression *&expr)
 {
+    TIME("check statements");
+
     const Type &t = promote(expr);
 
     if (t != error && !t.isSimple())
 	report(invalid_test);
 }
+
+
+/*
+ * Function:	openLoop
+ *
+ * Description:	Note that we are entering the body of a loop, in which a
+ *		break statement is allowed.
+ */
+
+void openLoop()
+{
+    compiler->breakable ++;
+}
+
+
+/*
+ * Function:	closeLoop
+ *
+ * Description:	Note that we are leaving the body of a loop.
+ */
+
+void closeLoop()
+{
+    compiler->breakable --;
+}
+
+
+/*
+ * Function:	openSwitch
+ *
+ * Description:	Check the expression of a switch statement, which must
+ *		have type int after promotion, and start collecting the
+ *		case labels of its body.
+ */
+
+void openSwitch(Expression *&expr)
+{
+    const Type &t = promote(expr);
+
+    if (t != error && !t.isInteger())
+	report(invalid_switch);
+
+    compiler->switches.push_back(Cases());
+    compiler->breakable ++;
+}
+
+
+/*
+ * Function:	closeSwitch
+ *
+ * Description:	Finish a switch statement and return it along with the
+ *		case labels found in its body.
+ */
+
+Statement *closeSwitch(Expression *expr, Statement *stmt)
+{
+    Statement *result = create<Switch>(expr, stmt, compiler->switches.back());
+
+    compiler->switches.pop_back();
+    compiler->breakable --;
+    return result;
+}
+
+
+/*
+ * Function:	checkCase
+ *
+ * Description:	Check a case label: it must be within a switch statement
+ *		and its value must not already be used by that switch.
+ */
+
+Statement *checkCase(long value)
+{
+    TIME("check statements");
+
+    Case *label = create<Case>(value);
+
+
+    if (compiler->switches.empty())
+	report(misplaced_label, "case");
+
+    else {
+	Cases &cases = compiler->switches.back();
+
+	for (unsigned i = 0; i < cases.size(); i ++)
+	    if (!cases[i]->isDefault() && cases[i]->value() == value) {
+		report(duplicate_case);
+		return label;
+	    }
+
+	cases.push_back(label);
+    }
+
+    return label;
+}
+
+
+/*
+ * Function:	checkDefault
+ *
+ * Description:	Check a default label: it must be within a switch
+ *		statement that does not already have one.
+ */
+
+Statement *checkDefault()
+{
+    TIME("check statements");
+
+    Case *label = create<Case>();
+
+
+    if (compiler->switches.empty())
+	report(misplaced_label, "default");
+
+    else {
+	Cases &cases = compiler->switches.back();
+
+	for (unsigned i = 0; i < cases.size(); i ++)
+	    if (cases[i]->isDefault()) {
+		report(duplicate_default);
+		return label;
+	    }
+
+	cases.push_back(label);
+    }
+
+    return label;
+}
+
+
+/*
+ * Function:	checkBreak
+ *
+ * Description:	Check a break statement: it must be within a loop or a
+ *		switch statement.
+ */
+
+Statement *checkBreak()
+{
+    TIME("check statements");
+
+    if (compiler->breakable == 0)
+	report(misplaced_break);
+
+    return create<Break>();
+}
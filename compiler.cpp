@@ -0,0 +1,119 @@
+/*
+ * File:	compiler.cpp
+ *
+ * Description:	This file contains the public function and variable
+ *		definitions for compiler contexts.  A context compiles one
+ *		program; use a new context for each compilation.
+ */
+
+# include <cstdio>
+# include <sstream>
+# include "cache.h"
+# include "compiler.h"
+# include "parser.h"
+
+using namespace std;
+
+thread_local CompilerContext *compiler;
+
+
+/*
+ * Function:	CompilerContext::CompilerContext (constructor)
+ *
+ * Description:	Initialize a compiler context with the given options.  With
+ *		a cache, the code of functions that have not changed is
+ *		reused (see incremental.cpp).  The target machine is the one
+ *		named by the options, which parseOptions() only sets to a
+ *		machine that exists.
+ */
+
+CompilerContext::CompilerContext(const Options &options)
+    : options(options), target(findMachine(options.target)), in(nullptr),
+      out(nullptr), err(nullptr), c(EOF), lineno(1), numerrors(0),
+      lookahead(0), nexttoken(0), outermost(nullptr), toplevel(nullptr),
+      breakable(0), pipeline(nullptr), cache(nullptr)
+{
+    if (!options.cacheDirectory.empty())
+	cache = new Cache(options.cacheDirectory, (unsigned long) options.cacheSize << 20);
+}
+
+
+/*
+ * Function:	CompilerContext::~CompilerContext (destructor)
+ *
+ * Description:	Release the cache and the scopes of the structure
+ *		definitions, the only scopes still held by the context once
+ *		it is done.
+ */
+
+CompilerContext::~CompilerContext()
+{
+    map<string, Scope *>::iterator it;
+
+    delete cache;
+
+    for (it = fields.begin(); it != fields.end(); it ++)
+	delete it->second;
+}
+
+
+/*
+ * Function:	CompilerContext::compile
+ *
+ * Description:	Compile the program read from IN, writing the assembly to
+ *		OUT and any errors to ERR.  The return value indicates
+ *		whether the program compiled without errors.  The calling
+ *		thread works on this context for the duration, and then
+ *		goes back to whatever context it had before.  A profile
+ *		that cannot be read is only warned about, and the program
+ *		is compiled as though none were given.
+ */
+
+bool CompilerContext::compile(istream &in, ostream &out, ostream &err)
+{
+    CompilerContext *previous = compiler;
+    bool parsed;
+
+
+    this->in = &in;
+    this->out = &out;
+    this->err = &err;
+
+    compiler = this;
+
+    if (!options.profileFile.empty() && !readProfile(options.profileFile, profile)) {
+	err << "scc: cannot read profile " << options.profileFile << endl;
+	profile.clear();
+    }
+
+    c = in.get();
+    parsed = parse();
+
+    if (options.memoryReport)
+	reportMemory(err, memory);
+
+    compiler = previous;
+
+    return parsed && numerrors == 0;
+}
+
+
+/*
+ * Function:	CompilerContext::compile
+ *
+ * Description:	Compile the program in the buffer SOURCE into the buffer
+ *		ASSEMBLY, with any errors in the buffer DIAGNOSTICS.
+ */
+
+bool CompilerContext::compile(const string &source, string &assembly, string &diagnostics)
+{
+    istringstream in(source);
+    ostringstream out, err;
+    bool compiled;
+
+
+    compiled = compile(in, out, err);
+    assembly = out.str();
+    diagnostics = err.str();
+    return compiled;
+}
@@ -0,0 +1,89 @@
+/*
+ * File:	compiler.h
+ *
+ * Description:	This file contains the class definition for a compiler
+ *		context, which compiles one Simple C program from a buffer
+ *		or stream into assembly.  The context owns all the state of
+ *		the compilation, so any number of contexts may compile at
+ *		once on different threads of the same process.
+ *
+ *		The lexer, parser, checker, and code generator reach the
+ *		context of the compilation they are working on through the
+ *		thread-local pointer compiler.  A thread started on behalf
+ *		of a compilation must set it before doing any work.
+ */
+
+# ifndef COMPILER_H
+# define COMPILER_H
+# include <map>
+# include <set>
+# include <mutex>
+# include <string>
+# include <vector>
+# include <istream>
+# include <ostream>
+# include "Tree.h"
+# include "Type.h"
+# include "Scope.h"
+# include "memory.h"
+# include "options.h"
+# include "profile.h"
+# include "machine.h"
+
+class Cache;
+struct Pipeline;
+
+class CompilerContext {
+public:
+    CompilerContext(const Options &options = Options());
+    ~CompilerContext();
+
+    bool compile(std::istream &in, std::ostream &out, std::ostream &err);
+    bool compile(const std::string &source, std::string &assembly,
+	    std::string &diagnostics);
+
+    /* The state of the compilation, shared by the stages of the compiler */
+
+    Options options;
+    const Machine *target;
+    std::istream *in;
+    std::ostream *out, *err;
+    std::mutex errLock;
+
+    int c, lineno, numerrors;
+
+    int lookahead, nexttoken;
+    std::string lexbuf, nextbuf;
+    Type returnType;
+    Symbols globals;
+    Functions functions;
+
+    std::map<std::string, Scope *> fields;
+    std::mutex fieldsLock;
+    Scope *outermost, *toplevel;
+    std::vector<Cases> switches;
+    unsigned breakable;
+
+    std::map<std::string, std::set<std::string> > strings;
+    std::mutex stringsLock;
+
+    Pipeline *pipeline;
+    Memory memory;
+    Profile profile;
+
+    std::map<const Statement *, int> lines;
+    std::mutex linesLock;
+
+    Cache *cache;
+    std::string span;
+    std::map<const Function *, std::string> keys;
+    std::mutex keysLock;
+
+private:
+    CompilerContext(const CompilerContext &);
+    CompilerContext &operator =(const CompilerContext &);
+};
+
+extern thread_local CompilerContext *compiler;
+
+# endif /* COMPILER_H */
@@ -0,0 +1,167 @@
+/*
+ * File:	cost.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for the static cost model of the generated
+ *		code.  The assembly of a function is read back, and its
+ *		instructions and memory accesses are counted.  The size of
+ *		its frame is taken from the .set directive that ends it.
+ *		Its cycles are estimated from a table of the latencies of
+ *		the instructions, with a fixed cost for each access.
+ *
+ *		The estimate is static: every instruction counts once, no
+ *		matter how often it runs, and instructions are assumed not
+ *		to overlap.  It is meant for comparing functions, and
+ *		versions of one function, rather than for predicting time.
+ */
+
+# include <map>
+# include <cctype>
+# include <cstdlib>
+# include <sstream>
+# include "cost.h"
+
+using namespace std;
+
+/* An access to memory adds the latency of a load from the first-level cache */
+
+# define ACCESS_LATENCY 4
+
+/* The latencies of the slower instructions; all others take one cycle */
+
+static const map<string, unsigned> latencies = {
+    {"imull", 3}, {"idivl", 26}, {"divl", 26}, {"call", 3}, {"ret", 2},
+    {"leave", 2},
+};
+
+
+/*
+ * Function:	Cost::Cost (constructor)
+ *
+ * Description:	Initialize a cost to nothing.
+ */
+
+Cost::Cost()
+    : instructions(0), accesses(0), frame(0), cycles(0)
+{
+}
+
+
+/*
+ * Function:	operands
+ *
+ * Description:	Split the operands of an instruction, which are separated
+ *		by commas outside of parentheses.
+ */
+
+static void operands(const string &text, string *result, unsigned &count)
+{
+    unsigned depth = 0;
+
+
+    count = 0;
+    result[0].clear();
+
+    for (unsigned i = 0; i < text.size(); i ++)
+	if (text[i] == ',' && depth == 0 && count < 2)
+	    result[++ count].clear();
+	else if (!isspace(text[i])) {
+	    depth += (text[i] == '(') - (text[i] == ')');
+	    result[count] += text[i];
+	}
+
+    count += !result[0].empty();
+}
+
+
+/*
+ * Function:	isMemory
+ *
+ * Description:	Return whether an operand is in memory: anything that is
+ *		not an immediate or a register, such as an offset from a
+ *		register or the name of a global.
+ */
+
+static bool isMemory(const string &operand)
+{
+    return !operand.empty() && operand[0] != '$' && operand[0] != '%';
+}
+
+
+/*
+ * Function:	estimate
+ *
+ * Description:	Estimate the cost of the assembly of one function.  The
+ *		operand of a jump or call is a label rather than memory,
+ *		unless it is an indirect jump through a table, and the
+ *		operand of leal or leaq is only an address.  A call, return,
+ *		push, or pop reaches the stack as well.
+ */
+
+Cost estimate(const string &assembly)
+{
+    map<string, unsigned>::const_iterator it;
+    string line, mnemonic, rest, args[3];
+    istringstream in(assembly);
+    unsigned count, accesses;
+    size_t space;
+    Cost cost;
+
+
+    while (getline(in, line)) {
+	if (line.size() < 2 || line[0] != '\t')
+	    continue;
+
+	space = line.find_first_of(" \t", 1);
+	mnemonic = line.substr(1, space == string::npos ? string::npos : space - 1);
+	rest = (space == string::npos ? "" : line.substr(space + 1));
+
+	if (mnemonic == ".set") {
+	    cost.frame = strtoul(rest.substr(rest.rfind(',') + 1).c_str(), nullptr, 10);
+	    continue;
+	}
+
+	if (!isalpha(mnemonic[0]))
+	    continue;
+
+	accesses = 0;
+
+	if (mnemonic[0] == 'j')
+	    accesses = (rest[0] == '*');
+	else if (mnemonic != "call" && mnemonic != "leal" && mnemonic != "leaq") {
+	    operands(rest, args, count);
+
+	    for (unsigned i = 0; i < count; i ++)
+		accesses += isMemory(args[i]);
+	}
+
+	if (mnemonic == "call" || mnemonic == "ret" || mnemonic == "pushl" || mnemonic == "popl" ||
+		mnemonic == "pushq" || mnemonic == "popq")
+	    accesses ++;
+
+	it = latencies.find(mnemonic);
+	cost.instructions ++;
+	cost.accesses += accesses;
+	cost.cycles += (it != latencies.end() ? it->second : 1) + accesses * ACCESS_LATENCY;
+    }
+
+    return cost;
+}
+
+
+/*
+ * Function:	reportCost
+ *
+ * Description:	Write the cost of a function on one line.
+ */
+
+void reportCost(ostream &out, const string &name, const Cost &cost)
+{
+    stringstream report;
+
+
+    report << name << ": " << cost.instructions << " instructions, ";
+    report << cost.accesses << " memory accesses, " << cost.frame << "-byte frame, ";
+    report << "about " << cost.cycles << " cycles" << endl;
+    out << report.str();
+}
@@ -0,0 +1,23 @@
+/*
+ * File:	cost.h
+ *
+ * Description:	This file contains the structure definition and public
+ *		function declarations for the static cost model of the
+ *		generated code.
+ */
+
+# ifndef COST_H
+# define COST_H
+# include <string>
+# include <ostream>
+
+struct Cost {
+    unsigned instructions, accesses;
+    unsigned long frame, cycles;
+    Cost();
+};
+
+Cost estimate(const std::string &assembly);
+void reportCost(std::ostream &out, const std::string &name, const Cost &cost);
+
+# endif /* COST_H */
@@ -6,17 +6,117 @@
  *
  *		Extra functionality:
  *		- putting all the global declarations at the end
+ *		- strength reduction of multiplication and division by constants
+ *		- pooling string literals in .rodata with suffix sharing
+ *		- switch statements with jump tables and decision trees
+ *		- unrolling counted for loops
+ *		- removing dead code, hoisting loop invariants, and reusing
+ *		  common subexpressions (see optimizer.cpp)
+ *		- no jump to the epilogue from a final return statement
+ *		- generating functions in parallel, with labels numbered per
+ *		  function so the output does not depend on the order
+ *		- generating x86-64 System V code with -m64, with arguments
+ *		  in registers and globals addressed relative to %rip
  */
 
+# include <map>
+# include <set>
+# include <mutex>
+# include <atomic>
+# include <thread>
+# include <vector>
+# include <cctype>
 # include <sstream>
+# include <algorithm>
 # include <iostream>
+# include <cstdlib>
+# include <climits>
 # include "generator.h"
 # include "machine.h"
 # include "lexer.h"
+# include "tokens.h"
+# include "optimizer.h"
+# include "compiler.h"
+# include "memory.h"
+# include "incremental.h"
+# include "timing.h"
+# include "cost.h"
 
 using namespace std;
 
-static unsigned maxargs;
+struct Label;
+
+/*
+ * Struct: Context
+ *
+ * Description: The state of the function being generated, which used to be
+ *		kept in globals.  Each thread generates one function at a time
+ *		into its own stream, so functions can be generated in parallel.
+ */
+
+struct Context{
+	string name;				//Function name, which prefixes its labels
+	ostream &out;				//Where the code goes
+	int offset;				//Current offset for temps
+	unsigned maxargs;			//Most arguments to any call
+	unsigned labels;			//Labels numbered so far
+	unsigned blocks;			//Basic blocks numbered so far
+	Label *returnLabel;			//Label of the epilogue
+	Statement *lastStatement;		//Needs no jump to returnLabel
+	vector<Label> breakLabels;		//Exits of the enclosing loops and switches
+	set<const Symbol *> addressed;		//Variables whose address is taken
+	map<string, string> strings;		//Labels of the string literals used
+	const vector<unsigned long long> *counts;	//Block counts from a profile
+	stringstream cold;			//Code placed after the epilogue
+
+	Context(const string &name, ostream &out);
+};
+
+Context::Context(const string &name, ostream &out)
+	: name(name), out(out), offset(0), maxargs(0), labels(0), blocks(0),
+	  returnLabel(nullptr), lastStatement(nullptr), counts(nullptr)
+{
+}
+
+//The function this thread is generating
+static thread_local Context *context;
+
+//The registers of the first arguments on x86-64, as ints and as pointers
+static const char *argRegisters[][2] = {
+	{"%edi", "%rdi"}, {"%esi", "%rsi"}, {"%edx", "%rdx"},
+	{"%ecx", "%rcx"}, {"%r8d", "%r8"}, {"%r9d", "%r9"},
+};
+
+/*
+ * Function: reg, op
+ *
+ * Description: Name a register, or an instruction, for a value of the
+ *		given size.  Anything no wider than an int is handled in a
+ *		32-bit register, and a 64-bit pointer in a whole register.
+ */
+
+static string reg(const string &name, unsigned size)
+{
+	return (size > SIZEOF_INT ? "%r" : "%e") + name;
+}
+
+static string op(const string &name, unsigned size)
+{
+	return name + (size > SIZEOF_INT ? "q" : "l");
+}
+
+/*
+ * Function: global
+ *
+ * Description: Return the operand for the memory at a symbol, which is
+ *		relative to the instruction pointer if the code must be
+ *		position independent.
+ */
+
+static string global(const string &symbol)
+{
+	return symbol + (machine().positionIndependent ? "(%rip)" : "");
+}
 
 /*
  * Function: Expression
@@ -42,15 +142,16 @@ void Expression::generate()
  * Function: AssignTempOffset
  * 
  * This will increase the offset so that there is space for a temp variable
+ * Temps are stored a whole register at a time (and a field's temp holds
+ * its address), so each one gets at least a word, the size of a pointer
  *
  */
 
-int offset;
 void assignTempOffset(Expression *expr)
 {
 	stringstream ss;
-	offset -= expr->type().size();
-	ss << offset << "(%ebp)";
+	context->offset -= max(expr->type().size(), (unsigned) SIZEOF_PTR);
+	ss << context->offset << "(" << reg("bp", SIZEOF_PTR) << ")";
 	expr -> _operand = ss.str();
 }
 
@@ -62,375 +163,1574 @@ void assignTempOffset(Expression *expr)
  */
 
 struct Label{
-	static unsigned int counter;
-	int number;
+	string name;
 	Label();
 };
 
-// Set counter to zero
-unsigned Label::counter = 0;
-
-//Label Constructor
+//Label Constructor, numbering within the current function
 Label::Label()
 {
-	number = counter++;
+	stringstream ss;
+
+	ss << ".L" << context->name << "." << context->labels++;
+	name = ss.str();
 }
 
 //Overload ostream operator
 ostream &operator<<(ostream &ostr, const Label &label)
 {
-	ostr << ".L" << label.number;
+	ostr << label.name;
 	return ostr;
 }
 
-//Global Return Label (needs to be reused and set for every function)
-Label *returnLabel;
-
 /*
- * Function:	operator <<
+ * Function: countBlock
  *
- * Description:	Convenience function for writing the operand of an
- *		expression.
+ * Description: Number the next basic block of the function, and with
+ *		-finstrument count each entry to it in a 64-bit counter in
+ *		.bss, in two halves unless the target has 64-bit registers.
+ *		Blocks are numbered the same way whether or not they are
+ *		counted, so that a profile can be matched to them.  The
+ *		flags are dead wherever a block starts.
  */
 
-ostream &operator <<(ostream &ostr, Expression *expr)
+static unsigned countBlock(bool counted = true)
 {
-    return ostr << expr->_operand;
-}
+	unsigned block = context->blocks ++;
+	stringstream counter;
+
+	if(compiler->options.instrument && counted && SIZEOF_PTR == 8)
+	{
+		counter << context->name << ".counts+" << 8 * block;
+		context->out << "\taddq\t$1, " << global(counter.str()) << endl;
+	}
+	else if(compiler->options.instrument && counted)
+	{
+		context->out << "\taddl\t$1, " << context->name << ".counts+" << 8 * block << endl;
+		context->out << "\tadcl\t$0, " << context->name << ".counts+" << 8 * block + 4 << endl;
+	}
 
+	return block;
+}
 
 /*
- * Function:	Identifier::generate
+ * Function: generateLine
  *
- * Description:	Generate code for an identifier.  Since there is really no
- *		code to generate, we simply update our operand.
+ * Description: With -g, generate the line of the source on which a
+ *		statement starts, which the assembler keeps in the line
+ *		table of the object for debuggers and profilers.  The
+ *		statements made by the optimizer have no line of their own.
  */
 
-void Identifier::generate()
+static void generateLine(const Statement *stmt)
 {
-    stringstream ss;
+	if(!compiler->options.debug)
+		return;
 
+	lock_guard<mutex> lock(compiler->linesLock);
+	map<const Statement *, int>::const_iterator it = compiler->lines.find(stmt);
 
-    if (_symbol->_offset != 0)
-	ss << _symbol->_offset << "(%ebp)";
-    else
-	ss << global_prefix << _symbol->name();
-
-    _operand = ss.str();
+	if(it != compiler->lines.end())
+		context->out << "\t.loc\t1 " << it->second << endl;
 }
 
+/*
+ * Function: blockCount
+ *
+ * Description: Return the times a block was entered according to the
+ *		profile, or zero if the profile does not reach it.
+ */
+
+static unsigned long long blockCount(unsigned block)
+{
+	if(context->counts == nullptr || block >= context->counts->size())
+		return 0;
+
+	return (*context->counts)[block];
+}
 
 /*
- * Function:	Number::generate
+ * Function: generateArm
  *
- * Description:	Generate code for a number.  Since there is really no code
- *		to generate, we simply update our operand.
+ * Description: Generate one arm of an if, or its empty false path, as a
+ *		block of its own.  The code is returned rather than written
+ *		so that the arms can be placed once their counts are known.
  */
 
-void Number::generate()
+static string generateArm(Statement *stmt)
 {
-    stringstream ss;
+	stringstream arm;
+	streambuf *saved = context->out.rdbuf(arm.rdbuf());
 
-    ss << "$" << _value;
-    _operand = ss.str();
+	countBlock();
+
+	if(stmt != nullptr)
+	{
+		generateLine(stmt);
+		stmt -> generate();
+	}
+
+	context->out.rdbuf(saved);
+	return arm.str();
 }
 
+//An arm entered this many times less often than the other is cold
+static const unsigned COLD_RATIO = 8;
+
 /*
- * Function:	Character::generate
+ * Function: placeArms
  *
- * Description:	Generate code for a character.  Since there is really no code
- *		to generate, we simply update our operand. Use charval() for character value.
+ * Description: Place the arms of an if whose test has just been
+ *		compared to zero.  The first arm falls through from JUMP,
+ *		which is taken to the second.  A cold second arm is placed
+ *		after the epilogue, out of the way of the first, and jumps
+ *		back.
  */
 
-void Character::generate()
+static void placeArms(const char *jump, const string &first, const string &second, bool cold)
 {
+	Label skip;
+	Label exit;
 
-    stringstream ss;
+	context->out << "\t" << jump << "\t" << skip << endl;
+	context->out << first;
 
-    ss << "$" << charval(_value);
-    _operand = ss.str();
+	if(second.empty())
+		context->out << skip << ":" << endl;
+	else if(cold)
+	{
+		context->out << exit << ":" << endl;
+		context->cold << skip << ":" << endl << second;
+		context->cold << "\tjmp\t" << exit << endl;
+	}
+	else
+	{
+		context->out << "\tjmp\t" << exit << endl;
+		context->out << skip << ":" << endl << second;
+		context->out << exit << ":" << endl;
+	}
 }
 
-# if STACK_ALIGNMENT == 4
+//A switch with more cases than this gets a jump table or decision tree
+# define MAX_CHAIN_CASES 3
+
+//A jump table may have at most this many entries per case
+# define MAX_TABLE_SPREAD 3
+
+//The string literal pool of the compilation (compiler->strings) is keyed by
+//contents and emitted by generateStrings().  Functions label their strings
+//themselves, so a string has a label for each function that uses it, and
+//functions generated in parallel share the pool.
 
 /*
- * Function:	Call::generate
+ * Function: longerString, isSuffix
  *
- * Description:	Generate code for a function call expression, in which each
- *		argument is simply a variable or an integer literal.
+ * Description: Helpers for laying out the string pool.
+ */
+
+static bool longerString(const string &a, const string &b)
+{
+	return a.size() > b.size();
+}
+
+static bool isSuffix(const string &s, const string &of)
+{
+	return s.size() <= of.size() && of.compare(of.size() - s.size(), s.size(), s) == 0;
+}
+
+/*
+ * Function: decodeString
  *
- *		**NOTE: NEED TO FIX FUNCTION TO HANDLE RECURSION**
+ * Description: Convert a string literal, including its quotes, into the
+ *		bytes it denotes.  Escape sequences are handed to charval()
+ *		one at a time so the rules match character literals.
  */
 
-void Call::generate()
+static string decodeString(const string &literal)
 {
-	cerr << "function called" << endl;
-    unsigned numBytes = 0;
+	string s = literal.substr(1, literal.size() - 2), bytes;
+	unsigned i, length;
+	int value;
 
+	for(i = 0; i < s.size(); i += length)
+	{
+		length = 1;
 
-    for (int i = _args.size() - 1; i >= 0; i --) {
-	_args[i]->generate();
-	cout << "\tpushl\t" << _args[i] << endl;
-	numBytes += _args[i]->type().size();
-    }
+		if(s[i] == '\\' && i + 1 < s.size())
+		{
+			length = 2;
+
+			if(s[i + 1] == 'x')
+				while(i + length < s.size() && isxdigit(s[i + length]))
+					length ++;
+			else if(s[i + 1] >= '0' && s[i + 1] <= '7')
+				while(length < 4 && i + length < s.size() && s[i + length] >= '0' && s[i + length] <= '7')
+					length ++;
+		}
 
-    cout << "\tcall\t" << global_prefix << _id->name() << endl;
+		value = (length == 1 ? s[i] : charval(s.substr(i, length)));
 
-    if (numBytes > 0)
-	cout << "\taddl\t$" << numBytes << ", %esp" << endl;
-	
-	//store this into register %eax
-	//cout << "\tmovl\t" << this << ", %eax"  << endl;
-	//store register %eax into this
-	assignTempOffset(this);
-	cout << "\tmovl\t%eax, " << this  << endl;
+		if(value == -1)
+			bytes += s.substr(i, length);
+		else
+			bytes += (char) value;
+	}
 
+	return bytes;
 }
 
-# else
+/*
+ * Function: encodeString
+ *
+ * Description: Quote bytes for an .ascii directive, using octal escapes
+ *		for anything that is not plain printable text.
+ */
+
+static string encodeString(const string &bytes)
+{
+	stringstream ss;
+
+	ss << '"';
+
+	for(unsigned i = 0; i < bytes.size(); i ++)
+	{
+		unsigned char c = bytes[i];
+
+		if(c == '"' || c == '\\' || !isprint(c))
+			ss << '\\' << (char) ('0' + (c >> 6)) << (char) ('0' + (c >> 3 & 7)) << (char) ('0' + (c & 7));
+		else
+			ss << c;
+	}
+
+	ss << '"';
+	return ss.str();
+}
 
 /*
- * If the stack has to be aligned to a certain size before a function call
- * then we cannot push the arguments in the order we see them.  If we had
- * nested function calls, we cannot guarantee that the stack would be
- * aligned.
+ * Function:	operator <<
  *
- * Instead, we must know the maximum number of arguments so we can compute
- * the size of the frame.  Again, we cannot just move the arguments onto
- * the stack as we see them because of nested function calls.  Rather, we
- * have to generate code for all arguments first and then move the results
- * onto the stack.  This will likely cause a lot of spills.
+ * Description:	Convenience function for writing the operand of an
+ *		expression.
+ */
+
+ostream &operator <<(ostream &ostr, Expression *expr)
+{
+    return ostr << expr->_operand;
+}
+
+
+/*
+ * Function: isImmediate
  *
- * For now, since each argument is going to be either a number of in
- * memory, we just load it into %eax and then move %eax onto the stack.
+ * Description: Return whether the operand of an expression is an
+ *		immediate.  x86 takes an immediate as the source of a move
+ *		or push, but never as a destination.
  */
 
-void Call::generate()
+static bool isImmediate(Expression *expr)
 {
-	cerr << "function called" << endl;
-    if (_args.size() > maxargs)
-	maxargs = _args.size();
+	return !expr->_operand.empty() && expr->_operand[0] == '$';
+}
 
-    for (int i = _args.size() - 1; i >= 0; i --) {
-	_args[i]->generate();
-	cout << "\tmovl\t" << _args[i] << ", %eax" << endl;
-	cout << "\tmovl\t%eax, " << i * SIZEOF_ARG << "(%esp)" << endl;
-    }
+/*
+ * Function: byteImmediate
+ *
+ * Description: Return an immediate operand truncated to a byte, as the
+ *		movb %al store it replaces would have done.
+ */
 
-    cout << "\tcall\t" << global_prefix << _id->name() << endl;
-	assignTempOffset(this);
-	cout << "\tmovl\t%eax, " << this  << endl;
+static string byteImmediate(Expression *expr)
+{
+	stringstream ss;
 
+	ss << "$" << (strtol(expr->_operand.c_str() + 1, NULL, 0) & 0xff);
+	return ss.str();
 }
 
-# endif
+/*
+ * Function: width
+ *
+ * Description: Return the size at which an operation on two operands is
+ *		done, which is that of a pointer if either one is.
+ */
 
+static unsigned width(Expression *left, Expression *right)
+{
+	return max(left->type().size(), right->type().size());
+}
 
 /*
- * Function:	Assignment::generate
+ * Function: load
  *
- * Description:	Generate code for this assignment statement, in which the
- *		right-hand side is an integer literal and the left-hand
- *		side is an integer scalar variable.  Actually, the way
- *		we've written things, the right-side can be a variable too.
+ * Description: Load the operand of an expression into a register for a
+ *		value of the given size.  An int loaded for use with a
+ *		64-bit pointer is sign extended.
+ */
+
+static void load(Expression *expr, const string &name, unsigned size)
+{
+	if(size > SIZEOF_INT && !isImmediate(expr) && expr->type().size() < size)
+		context->out << "\tmovslq\t" << expr << ", " << reg(name, size) << endl;
+	else
+		context->out << "\t" << op("mov", size) << "\t" << expr << ", " << reg(name, size) << endl;
+}
+
+/*
+ * Function: source
  *
- *		As of phase 6, checks for lvalues and size
+ * Description: Return the operand of an expression as the source of an
+ *		instruction on values of the given size.  An int used with
+ *		a 64-bit pointer is sign extended into %rcx first.
  */
 
-void Assignment::generate()
+static string source(Expression *expr, unsigned size)
 {
-	//Indirect?
-	bool indirect = false;
-	//Do other generations
-    _left->generate(indirect);
-	cerr << "left part of assignment: " << _left << endl;
-    _right->generate();
-	cerr << "right part of assignment: " << _right << endl;
+	if(size <= SIZEOF_INT || isImmediate(expr) || expr->type().size() >= size)
+		return expr->_operand;
 
-	//Assign to either char or int
-    if(!indirect)
-	{
-		//Assign to char
-		if(_left->type().size() == 1)
-		{
-			//load
-			cout << "\tmovl\t" << _right << ", %eax" << endl;
-			//store
-			cout << "\tmovb\t%al, " << _left << endl;
-		}
-		//Assign to int
-		if(_left->type().size() == 4)
-		{
-			//load
-			cout << "\tmovl\t" << _right << ", %eax" << endl;
-			//store
-			cout << "\tmovl\t%eax, " << _left << endl;
-		}
-	}
-	//Assign to either char* or int*
-	else
-	{
-		//Assign to char*
-		if(_left->type().size() == 1)
-		{
-			//load
-			cout << "\tmovl\t" << _right << ", %eax" << endl;
-		
-			//op
-			cout << "\tmovl\t" << _left << ", %ecx" << endl;
-		
-			//store
-			cout << "\tmovb\t%al, (%ecx) " << endl;
-		}
-		//Assign to int*
-		if(_left->type().size() == 4)
-		{
-			//load
-			cout << "\tmovl\t" << _right << ", %eax" << endl;
+	load(expr, "cx", size);
+	return "%rcx";
+}
 
-			//op
-			cout << "\tmovl\t" << _left << ", %ecx" << endl;
+/*
+ * Function: compareToZero
+ *
+ * Description: Compare the operand of an expression against zero.  An
+ *		immediate cannot be the second operand of cmpl, so in that
+ *		case it is loaded into %eax first.
+ */
 
-			//store
-			cout << "\tmovl\t%eax, (%ecx)" << endl;
-		}
+static void compareToZero(Expression *expr)
+{
+	if(isImmediate(expr))
+	{
+		context->out << "\tmovl\t" << expr << ", %eax" << endl;
+		context->out << "\tcmpl\t$0, %eax" << endl;
 	}
+	else
+		context->out << "\t" << op("cmp", expr->type().size()) << "\t$0, " << expr << endl;
 }
 
 
 /*
- * Function:	Block::generate
+ * Function: isConstant
  *
- * Description:	Generate code for this block, which simply means we
- *		generate code for each statement within the block.
+ * Description: Return whether the expression is an integer literal that
+ *		fits in a signed 32-bit immediate, and if so its value.
+ *		The checker always builds element-size scaling with a
+ *		Number, so this is all we need to recognize.
  */
 
-void Block::generate()
+static bool isConstant(Expression *expr, long &value)
 {
-    for (unsigned i = 0; i < _stmts.size(); i ++)
-	_stmts[i]->generate();
+	Number *number = dynamic_cast<Number *>(expr);
+
+	if(number == nullptr)
+		return false;
+
+	value = strtol(number->value().c_str(), NULL, 0);
+	return value >= 0 && value <= INT_MAX;
 }
 
+/*
+ * Struct:	CountedLoop
+ *
+ * Description:	What the unroller knows about a for loop of the form
+ *		for (i = start; i op bound; i = i + stride), where i and
+ *		bound do not change in the body.
+ */
+
+struct CountedLoop {
+	const Symbol *counter;
+	long stride;
+	int op;
+	Expression *bound;
+	bool constant;
+	long trips;
+};
 
 /*
- * Function:	Function::generate
+ * Function:	localInteger
  *
- * Description:	Generate code for this function, which entails allocating
- *		space for local variables, then emitting our prologue, the
- *		body of the function, and the epilogue.
+ * Description:	Return the symbol of an expression that is a local int
+ *		variable whose address is never taken in this function, or
+ *		null.  Only such a variable is certain not to change behind
+ *		the unroller's back.
  */
 
-void Function::generate()
+static const Symbol *localInteger(Expression *expr)
 {
-    offset = 0;
-	returnLabel = new Label();
+	Identifier *id = dynamic_cast<Identifier *>(expr);
 
-    /* Generate our prologue. */
+	if(id == nullptr || id->symbol()->_offset == 0)
+		return nullptr;
 
-    allocate(offset);
-    cout << global_prefix << _id->name() << ":" << endl;
-    cout << "\tpushl\t%ebp" << endl;
-    cout << "\tmovl\t%esp, %ebp" << endl;
-    cout << "\tsubl\t$" << _id->name() << ".size, %esp" << endl;
+	if(id->symbol()->type() != Type("int") || context->addressed.count(id->symbol()) > 0)
+		return nullptr;
 
+	return id->symbol();
+}
 
-    /* Generate the body of this function. */
+/*
+ * Function:	isAssigned
+ *
+ * Description:	Return whether the tree assigns to the given variable.
+ */
 
-	maxargs = 0;
-	_body->generate();
+static bool isAssigned(Statement *stmt, const Symbol *symbol)
+{
+	Substatements stmts;
+	Subexpressions exprs;
+	Identifier *id;
 
-	offset -= maxargs * SIZEOF_ARG;
+	stmt->children(stmts, exprs);
 
-	while ((offset - PARAM_OFFSET) % STACK_ALIGNMENT)
-		offset --;
+	if(dynamic_cast<Assignment *>(stmt) != nullptr)
+		if((id = dynamic_cast<Identifier *>(*exprs[0])) != nullptr && id->symbol() == symbol)
+			return true;
 
+	for(unsigned i = 0; i < stmts.size(); i ++)
+		if(isAssigned(*stmts[i], symbol))
+			return true;
 
-	/* Generate our epilogue. */
+	return false;
+}
 
-	//Generate new label for return
-	cout << *returnLabel << ":" << endl;
+/*
+ * Function:	hasOuterCase
+ *
+ * Description:	Return whether the tree contains a case label belonging
+ *		to a switch outside of it.  Copying such a tree would define
+ *		the label twice.
+ */
 
-	cout << "\tmovl\t%ebp, %esp" << endl;
-	cout << "\tpopl\t%ebp" << endl;
-	cout << "\tret" << endl << endl;
+static bool hasOuterCase(Statement *stmt)
+{
+	Substatements stmts;
+	Subexpressions exprs;
 
-	cout << "\t.globl\t" << global_prefix << _id->name() << endl;
-	cout << "\t.set\t" << _id->name() << ".size, " << -offset << endl;
+	if(dynamic_cast<Case *>(stmt) != nullptr)
+		return true;
 
-	cout << endl;
-}
+	if(dynamic_cast<Switch *>(stmt) != nullptr)
+		return false;
+
+	stmt->children(stmts, exprs);
+
+	for(unsigned i = 0; i < stmts.size(); i ++)
+		if(hasOuterCase(*stmts[i]))
+			return true;
 
+	return false;
+}
 
 /*
- * Function:	generateGlobals
+ * Function:	isCountedLoop
  *
- * Description:	Generate code for any global variable declarations.
+ * Description:	Recognize a counted for loop and fill in what we know
+ *		about it.  The counter must be a local int set by the
+ *		initialization, compared against a constant, an unchanging
+ *		local, or a bound hoisted out of the loop, and stepped by a
+ *		constant in the direction of the comparison.
  */
 
-void generateGlobals(const Symbols &globals)
+static bool isCountedLoop(Statement *init, Expression *test, Statement *incr, Statement *body, CountedLoop &loop)
 {
-	if (globals.size() > 0)
-		cout << "\t.data" << endl;
+	Substatements stmts;
+	Subexpressions exprs, parts, step;
+	long start, bound;
 
-	for (unsigned i = 0; i < globals.size(); i ++) {
-		cout << "\t.comm\t" << global_prefix << globals[i]->name();
-		cout << ", " << globals[i]->type().size();
-		cout << ", " << globals[i]->type().alignment() << endl;
-	}
+	if(init == nullptr || test == nullptr || incr == nullptr)
+		return false;
+
+	if(dynamic_cast<Assignment *>(init) == nullptr || dynamic_cast<Assignment *>(incr) == nullptr)
+		return false;
+
+	//Initialization: i = start
+	init->children(stmts, exprs);
+
+	if((loop.counter = localInteger(*exprs[0])) == nullptr)
+		return false;
+
+	loop.constant = isConstant(*exprs[1], start);
+
+	//Test: i op bound
+	if(dynamic_cast<LessThan *>(test) != nullptr)
+		loop.op = '<';
+	else if(dynamic_cast<LessOrEqual *>(test) != nullptr)
+		loop.op = LEQ;
+	else if(dynamic_cast<GreaterThan *>(test) != nullptr)
+		loop.op = '>';
+	else if(dynamic_cast<GreaterOrEqual *>(test) != nullptr)
+		loop.op = GEQ;
+	else
+		return false;
+
+	test->children(stmts, parts);
+
+	if(localInteger(*parts[0]) != loop.counter)
+		return false;
+
+	loop.bound = *parts[1];
+
+	if(isConstant(loop.bound, bound))
+		;
+	else if(dynamic_cast<Reuse *>(loop.bound) != nullptr)
+		loop.constant = false;
+	else if(localInteger(loop.bound) == nullptr || isAssigned(body, localInteger(loop.bound)))
+		return false;
+	else
+		loop.constant = false;
+
+	//Increment: i = i + stride, i = stride + i, or i = i - stride
+	exprs.clear();
+	incr->children(stmts, exprs);
+
+	if(localInteger(*exprs[0]) != loop.counter)
+		return false;
+
+	if(dynamic_cast<Add *>(*exprs[1]) != nullptr)
+	{
+		(*exprs[1])->children(stmts, step);
+
+		if(localInteger(*step[0]) == loop.counter && isConstant(*step[1], loop.stride))
+			;
+		else if(localInteger(*step[1]) == loop.counter && isConstant(*step[0], loop.stride))
+			;
+		else
+			return false;
+	}
+	else if(dynamic_cast<Subtract *>(*exprs[1]) != nullptr)
+	{
+		(*exprs[1])->children(stmts, step);
+
+		if(localInteger(*step[0]) != loop.counter || !isConstant(*step[1], loop.stride))
+			return false;
+
+		loop.stride = -loop.stride;
+	}
+	else
+		return false;
+
+	if(loop.stride == 0 || (loop.stride > 0) != (loop.op == '<' || loop.op == LEQ))
+		return false;
+
+	//Body: the counter only changes in the increment
+	if(isAssigned(body, loop.counter) || hasOuterCase(body))
+		return false;
+
+	//Constant trip count
+	if(loop.constant)
+	{
+		long span = (loop.stride > 0 ? bound - start : start - bound);
+		long stride = labs(loop.stride);
+
+		if(loop.op == '<' || loop.op == '>')
+			loop.trips = (span <= 0 ? 0 : (span + stride - 1) / stride);
+		else
+			loop.trips = (span < 0 ? 0 : span / stride + 1);
+	}
+
+	return true;
+}
+
+/*
+ * Function:	unrollGuard
+ *
+ * Description:	Build the test, made once the loop test has passed, that
+ *		at least COUNT more iterations remain: the distance from
+ *		the counter to the bound covers COUNT - 1 strides.  That
+ *		distance is not negative, so if it overflows it wraps to a
+ *		negative value and fails, leaving the iterations to the
+ *		remainder.  Advancing the counter instead could wrap past
+ *		the bound and pass.
+ */
+
+static Expression *unrollGuard(const CountedLoop &loop, unsigned count)
+{
+	Expression *counter = create<Identifier>(loop.counter), *distance;
+	Number *span = create<Number>((unsigned) ((count - 1) * labs(loop.stride)));
+	Type integer("int");
+
+	if(loop.stride > 0)
+		distance = create<Subtract>(loop.bound, counter, integer);
+	else
+		distance = create<Subtract>(counter, loop.bound, integer);
+
+	if(loop.op == '<' || loop.op == '>')
+		return create<GreaterThan>(distance, span, integer);
+
+	return create<GreaterOrEqual>(distance, span, integer);
+}
+
+/*
+ * Function:	Identifier::generate
+ *
+ * Description:	Generate code for an identifier.  Since there is really no
+ *		code to generate, we simply update our operand.
+ */
+
+void Identifier::generate()
+{
+	TIME("generate Identifier");
+
+    stringstream ss;
+
+
+    if (_symbol->_offset != 0)
+	ss << _symbol->_offset << "(" << reg("bp", SIZEOF_PTR) << ")";
+    else
+	ss << global(global_prefix + _symbol->name());
+
+    _operand = ss.str();
+}
+
+
+/*
+ * Function:	Number::generate
+ *
+ * Description:	Generate code for a number.  Since there is really no code
+ *		to generate, we simply update our operand.
+ */
+
+void Number::generate()
+{
+	TIME("generate Number");
+
+    stringstream ss;
+
+    ss << "$" << _value;
+    _operand = ss.str();
+}
+
+/*
+ * Function:	Character::generate
+ *
+ * Description:	Generate code for a character.  Since there is really no code
+ *		to generate, we simply update our operand. Use charval() for character value.
+ */
+
+void Character::generate()
+{
+	TIME("generate Character");
+
+    stringstream ss;
+
+    ss << "$" << charval(_value);
+    _operand = ss.str();
+}
+
+/*
+ * Function:	pushArguments
+ *
+ * Description:	Push each argument of a call as soon as it is generated,
+ *		and return the bytes to pop after the call.  This is only
+ *		possible if the stack need not be aligned at a call.
+ */
+
+static unsigned pushArguments(const Expressions &args)
+{
+    unsigned numBytes = 0;
+
+
+    for (int i = args.size() - 1; i >= 0; i --) {
+	args[i]->generate();
+	context->out << "\tpushl\t" << args[i] << endl;
+	numBytes += args[i]->type().size();
+    }
+
+    return numBytes;
+}
+
+
+/*
+ * If the stack has to be aligned to a certain size before a function call
+ * then we cannot push the arguments in the order we see them.  If we had
+ * nested function calls, we cannot guarantee that the stack would be
+ * aligned.
+ *
+ * Instead, we must know the maximum number of arguments so we can compute
+ * the size of the frame.  Again, we cannot just move the arguments onto
+ * the stack as we see them because of nested function calls.  Rather, we
+ * have to generate code for all arguments first and then move the results
+ * onto the stack.  This will likely cause a lot of spills.
+ *
+ * Since each argument is then either an immediate or in memory, we store
+ * an immediate directly and load anything else into %eax first, as x86
+ * has no memory-to-memory move.
+ */
+
+static unsigned moveArguments(const Expressions &args)
+{
+    if (args.size() > context->maxargs)
+	context->maxargs = args.size();
+
+    for (int i = args.size() - 1; i >= 0; i --)
+	args[i]->generate();
+
+    for (int i = args.size() - 1; i >= 0; i --) {
+	if (isImmediate(args[i]))
+	    context->out << "\tmovl\t" << args[i] << ", " << i * SIZEOF_ARG << "(%esp)" << endl;
+	else {
+	    context->out << "\tmovl\t" << args[i] << ", %eax" << endl;
+	    context->out << "\tmovl\t%eax, " << i * SIZEOF_ARG << "(%esp)" << endl;
+	}
+    }
+
+    return 0;
+}
+
+
+/*
+ * Function:	passArguments
+ *
+ * Description:	Pass the arguments of a call as the x86-64 System V ABI
+ *		does: the first six in registers, and the rest pushed in
+ *		eight bytes each, last first.  All of the arguments are
+ *		generated before any is passed, since a nested call would
+ *		clobber the registers.  The stack is kept aligned to
+ *		sixteen bytes at the call, and %al holds the number of
+ *		vector registers used, none, in case the function takes a
+ *		variable number of arguments.  The bytes to pop after the
+ *		call are returned.
+ */
+
+static unsigned passArguments(const Expressions &args)
+{
+    unsigned numBytes = 0, size;
+
+
+    for (int i = args.size() - 1; i >= 0; i --)
+	args[i]->generate();
+
+    if (args.size() > REGISTER_ARGS && (args.size() - REGISTER_ARGS) % 2 != 0) {
+	context->out << "\tsubq\t$8, %rsp" << endl;
+	numBytes += 8;
+    }
+
+    for (int i = args.size() - 1; i >= (int) REGISTER_ARGS; i --) {
+	if (isImmediate(args[i]))
+	    context->out << "\tpushq\t" << args[i] << endl;
+	else {
+	    load(args[i], "ax", SIZEOF_ARG);
+	    context->out << "\tpushq\t%rax" << endl;
+	}
+
+	numBytes += SIZEOF_ARG;
+    }
+
+    for (unsigned i = 0; i < args.size() && i < REGISTER_ARGS; i ++) {
+	size = args[i]->type().size();
+	context->out << "\t" << op("mov", size) << "\t" << args[i] << ", ";
+	context->out << argRegisters[i][size > SIZEOF_INT] << endl;
+    }
+
+    context->out << "\tmovl\t$0, %eax" << endl;
+    return numBytes;
+}
+
+
+/*
+ * Function:	Call::generate
+ *
+ * Description:	Generate code for a function call expression, in which each
+ *		argument is simply a variable or an integer literal.  The
+ *		arguments are passed as the target machine expects.  On
+ *		x86-64, a function is called through the procedure linkage
+ *		table, in case it is in a shared library.
+ */
+
+void Call::generate()
+{
+	TIME("generate Call");
+
+	cerr << "function called" << endl;
+    unsigned numBytes, size = _type.size();
+
+
+    if (REGISTER_ARGS > 0)
+	numBytes = passArguments(_args);
+    else if (STACK_ALIGNMENT == 4)
+	numBytes = pushArguments(_args);
+    else
+	numBytes = moveArguments(_args);
+
+    context->out << "\tcall\t" << global_prefix << _id->name();
+    context->out << (machine().positionIndependent ? plt_suffix : "") << endl;
+
+    if (numBytes > 0)
+	context->out << "\t" << op("add", SIZEOF_PTR) << "\t$" << numBytes << ", " << reg("sp", SIZEOF_PTR) << endl;
+
+    //store register %eax into this
+    assignTempOffset(this);
+    context->out << "\t" << op("mov", size) << "\t" << reg("ax", size) << ", " << this << endl;
+}
+
+
+/*
+ * Function:	Assignment::generate
+ *
+ * Description:	Generate code for this assignment statement, in which the
+ *		right-hand side is an integer literal and the left-hand
+ *		side is an integer scalar variable.  Actually, the way
+ *		we've written things, the right-side can be a variable too.
+ *
+ *		As of phase 6, checks for lvalues and size
+ */
+
+void Assignment::generate()
+{
+	TIME("generate Assignment");
+
+	//Indirect?
+	bool indirect = false;
+	//Source operand of the store
+	string source;
+	//Size of the store
+	unsigned size = _left->type().size();
+	//Do other generations
+    _left->generate(indirect);
+	cerr << "left part of assignment: " << _left << endl;
+    _right->generate();
+	cerr << "right part of assignment: " << _right << endl;
+
+	//An immediate can be stored directly, anything else goes through %eax
+	if(isImmediate(_right))
+	{
+		source = (size == 1 ? byteImmediate(_right) : _right->_operand);
+	}
+	else
+	{
+		//load
+		load(_right, "ax", size > SIZEOF_INT ? SIZEOF_PTR : SIZEOF_INT);
+		source = (size == 1 ? "%al" : reg("ax", size));
+	}
+
+	//Assign to either char or int
+    if(!indirect)
+	{
+		//Assign to char
+		if(_left->type().size() == 1)
+		{
+			//store
+			context->out << "\tmovb\t" << source << ", " << _left << endl;
+		}
+		//Assign to int
+		if(_left->type().size() == 4)
+		{
+			//store
+			context->out << "\tmovl\t" << source << ", " << _left << endl;
+		}
+		//Assign to a 64-bit pointer
+		if(_left->type().size() == 8)
+		{
+			//store
+			context->out << "\tmovq\t" << source << ", " << _left << endl;
+		}
+	}
+	//Assign to either char* or int*
+	else
+	{
+		string address = "(" + reg("cx", SIZEOF_PTR) + ")";
+
+		//op
+		context->out << "\t" << op("mov", SIZEOF_PTR) << "\t" << _left << ", " << reg("cx", SIZEOF_PTR) << endl;
+
+		//Assign to char*
+		if(_left->type().size() == 1)
+		{
+			//store
+			context->out << "\tmovb\t" << source << ", " << address << endl;
+		}
+		//Assign to int*
+		if(_left->type().size() == 4)
+		{
+			//store
+			context->out << "\tmovl\t" << source << ", " << address << endl;
+		}
+		//Assign to a 64-bit pointer through a pointer
+		if(_left->type().size() == 8)
+		{
+			//store
+			context->out << "\tmovq\t" << source << ", " << address << endl;
+		}
+	}
+}
+
+
+/*
+ * Function:	Block::generate
+ *
+ * Description:	Generate code for this block, which simply means we
+ *		generate code for each statement within the block.
+ */
+
+void Block::generate()
+{
+	TIME("generate Block");
+
+    for (unsigned i = 0; i < _stmts.size(); i ++) {
+	generateLine(_stmts[i]);
+	_stmts[i]->generate();
+    }
+}
+
+
+/*
+ * Function: generateRecords
+ *
+ * Description: Generate the records of the function being generated
+ *		that the runtime of an instrumented program reads.  It
+ *		finds them by the bounds the linker gives their sections.
+ *		With -finstrument, a record in scc_profile has the name of
+ *		the function, its number of blocks, and its block counters.
+ *		With -finstrument-functions, a record in scc_functions has
+ *		the address of the function and its name, so that the
+ *		hooks can name the functions they are called for.  The
+ *		records are laid out as the C structures of the runtime,
+ *		so on x86-64 a pointer takes eight bytes and the number of
+ *		blocks is padded to match.
+ */
+
+static void generateRecords()
+{
+	const string &name = context->name;
+
+	if(compiler->options.instrument)
+	{
+		context->out << "\t.local\t" << name << ".counts" << endl;
+		context->out << "\t.comm\t" << name << ".counts, " << 8 * context->blocks << ", 8" << endl;
+	}
+
+	context->out << "\t.section\t.rodata" << endl;
+	context->out << name << ".name:\t.asciz\t\"" << name << "\"" << endl;
+
+	if(compiler->options.instrument)
+	{
+		context->out << "\t.section\tscc_profile, \"aw\"" << endl;
+		context->out << "\t.align\t" << ALIGNOF_PTR << endl;
+
+		if(SIZEOF_PTR == 8)
+		{
+			context->out << "\t.quad\t" << name << ".name" << endl;
+			context->out << "\t.long\t" << context->blocks << ", 0" << endl;
+			context->out << "\t.quad\t" << name << ".counts" << endl;
+		}
+		else
+			context->out << "\t.long\t" << name << ".name, " << context->blocks << ", " << name << ".counts" << endl;
+	}
+
+	if(compiler->options.instrumentFunctions)
+	{
+		context->out << "\t.section\tscc_functions, \"aw\"" << endl;
+		context->out << "\t.align\t" << ALIGNOF_PTR << endl;
+		context->out << "\t" << (SIZEOF_PTR == 8 ? ".quad" : ".long") << "\t" << global_prefix << name << ", " << name << ".name" << endl;
+	}
+
+	context->out << "\t.text" << endl;
+}
+
+/*
+ * Function: callHook
+ *
+ * Description: Call a hook of -finstrument-functions with the address of
+ *		the function being generated and the address it was called
+ *		from, which is its return address.  On x86-64 these go in
+ *		the first two argument registers.
+ */
+
+static void callHook(const string &hook)
+{
+	if(REGISTER_ARGS > 0)
+	{
+		context->out << "\tleaq\t" << global(global_prefix + context->name) << ", %rdi" << endl;
+		context->out << "\tmovq\t8(%rbp), %rsi" << endl;
+		context->out << "\tcall\t" << global_prefix << hook << plt_suffix << endl;
+		return;
+	}
+
+	context->out << "\tpushl\t4(%ebp)" << endl;
+	context->out << "\tpushl\t$" << global_prefix << context->name << endl;
+	context->out << "\tcall\t" << global_prefix << hook << endl;
+	context->out << "\taddl\t$8, %esp" << endl;
+}
+
+
+/*
+ * Function: storeParameters
+ *
+ * Description: Store the parameters passed in registers, which are the
+ *		first of the symbols of the function's body, into the
+ *		places in the frame allocated for them.
+ */
+
+static void storeParameters(unsigned count, const Symbols &symbols)
+{
+	unsigned size;
+
+	for(unsigned i = 0; i < count && i < REGISTER_ARGS; i ++)
+	{
+		size = symbols[i]->type().size();
+		context->out << "\t" << op("mov", size) << "\t" << argRegisters[i][size > SIZEOF_INT] << ", ";
+		context->out << symbols[i]->_offset << "(%rbp)" << endl;
+	}
+}
+
+
+/*
+ * Function:	reportCode
+ *
+ * Description:	Report the size and static cost of the code of a function
+ *		(see cost.cpp).
+ */
+
+static void reportCode(const string &name, const string &assembly)
+{
+	lock_guard<mutex> lock(compiler->errLock);
+	reportCost(*compiler->err, name, estimate(assembly));
+}
+
+
+/*
+ * Function:	Function::generate
+ *
+ * Description:	Generate code for this function, which entails allocating
+ *		space for local variables, then emitting our prologue, the
+ *		body of the function, and the epilogue.  Everything we need
+ *		to keep track of along the way is in our own context, so
+ *		several functions can be generated at once.
+ */
+
+void Function::generate(ostream &output)
+{
+	TIME("generate Function");
+
+	string key, assembly;
+	stringstream buffer;
+
+	//Reuse the code of an unchanged function, except for a report
+	if(compiler->cache != nullptr && !compiler->options.optimizeReport)
+	{
+		if(findFunction(this, key, assembly))
+		{
+			if(compiler->options.codeReport)
+				reportCode(_id->name(), assembly);
+
+			output << assembly;
+			return;
+		}
+	}
+
+	//A function with a key or a report is kept in a buffer until it is done
+	bool buffered = !key.empty() || compiler->options.codeReport;
+	ostream &out = buffered ? buffer : output;
+	Context state(_id->name(), out);
+
+	context = &state;
+	Label returnLabel;
+	context->returnLabel = &returnLabel;
+
+	if(compiler->profile.count(_id->name()) > 0)
+		context->counts = &compiler->profile[_id->name()];
+
+	if(compiler->options.unrollFactor > 1)
+		findAddressed(_body, context->addressed);
+
+    /* Generate our prologue. */
+
+    allocate(context->offset);
+
+	//Optimize the body now that the variables have their offsets
+	if(compiler->options.optimize)
+	{
+		unsigned removed = eliminateDead(_body);
+		unsigned hoisted = hoistInvariants(_body);
+		unsigned reused = eliminateCommon(_body);
+
+		if(compiler->options.optimizeReport)
+		{
+			stringstream report;
+
+			report << _id->name() << ": " << removed << " dead statements removed" << endl;
+			report << _id->name() << ": " << hoisted << " loop-invariant expressions hoisted" << endl;
+			report << _id->name() << ": " << reused << " common subexpressions reused" << endl;
+			lock_guard<mutex> lock(compiler->errLock);
+			*compiler->err << report.str();
+		}
+	}
+
+	if(symbol_types)
+		out << "\t.type\t" << global_prefix << _id->name() << ", @function" << endl;
+
+    out << global_prefix << _id->name() << ":" << endl;
+	generateLine(_body);
+    out << "\t" << op("push", SIZEOF_PTR) << "\t" << reg("bp", SIZEOF_PTR) << endl;
+    out << "\t" << op("mov", SIZEOF_PTR) << "\t" << reg("sp", SIZEOF_PTR) << ", " << reg("bp", SIZEOF_PTR) << endl;
+    out << "\t" << op("sub", SIZEOF_PTR) << "\t$" << _id->name() << ".size, " << reg("sp", SIZEOF_PTR) << endl;
+	storeParameters(_id->type().parameters()->size(), _body->declarations()->symbols());
+	countBlock();
+
+	if(compiler->options.instrumentFunctions)
+		callHook(compiler->options.entryHook);
+
+
+    /* Generate the body of this function. */
+
+	//A return at the very end falls through to the epilogue
+	context->lastStatement = _body;
+
+	while(dynamic_cast<Block *>(context->lastStatement) != nullptr)
+	{
+		Substatements stmts;
+		Subexpressions exprs;
+
+		context->lastStatement->children(stmts, exprs);
+
+		if(stmts.empty())
+			break;
+
+		context->lastStatement = *stmts.back();
+	}
+
+	_body->generate();
+
+	context->offset -= context->maxargs * SIZEOF_ARG;
+
+	while ((context->offset - PARAM_OFFSET) % STACK_ALIGNMENT)
+		context->offset --;
+
+
+	/* Generate our epilogue. */
+
+	//Generate new label for return
+	out << returnLabel << ":" << endl;
+
+	//The exit hook must keep the return value, and on x86-64 the stack aligned
+	if(compiler->options.instrumentFunctions)
+	{
+		out << "\t" << op("push", SIZEOF_PTR) << "\t" << reg("ax", SIZEOF_PTR) << endl;
+
+		if(SIZEOF_PTR == 8)
+			out << "\tsubq\t$8, %rsp" << endl;
+
+		callHook(compiler->options.exitHook);
+
+		if(SIZEOF_PTR == 8)
+			out << "\taddq\t$8, %rsp" << endl;
+
+		out << "\t" << op("pop", SIZEOF_PTR) << "\t" << reg("ax", SIZEOF_PTR) << endl;
+	}
+
+	out << "\t" << op("mov", SIZEOF_PTR) << "\t" << reg("bp", SIZEOF_PTR) << ", " << reg("sp", SIZEOF_PTR) << endl;
+	out << "\t" << op("pop", SIZEOF_PTR) << "\t" << reg("bp", SIZEOF_PTR) << endl;
+	out << "\tret" << endl << endl;
+
+	//Cold code from a profile goes where it is never fallen into
+	if(!context->cold.str().empty())
+		out << context->cold.str() << endl;
+
+	if(symbol_types)
+		out << "\t.size\t" << global_prefix << _id->name() << ", .-" << global_prefix << _id->name() << endl;
+
+	out << "\t.globl\t" << global_prefix << _id->name() << endl;
+	out << "\t.set\t" << _id->name() << ".size, " << -context->offset << endl;
+
+	if(compiler->options.instrument || compiler->options.instrumentFunctions)
+		generateRecords();
+
+	out << endl;
+
+	//Keep the code for the next compilation
+	if(!key.empty())
+		insertFunction(key, buffer.str(), context->strings);
+
+	if(compiler->options.codeReport)
+		reportCode(_id->name(), buffer.str());
+
+	if(buffered)
+		output << buffer.str();
+
+	context = nullptr;
+}
+
+
+/*
+ * Function:	generateFunction
+ *
+ * Description:	Take the next function that no other thread has taken
+ *		and generate it into its own buffer, until none are left.
+ *		The thread works on the compilation of its parent.
+ */
+
+static void generateFunction(CompilerContext *parent, const Functions *functions, vector<string> *buffers, atomic<unsigned> *next)
+{
+	unsigned i;
+
+	compiler = parent;
+
+	while((i = (*next) ++) < functions->size())
+	{
+		stringstream out;
+
+		(*functions)[i]->generate(out);
+		(*buffers)[i] = out.str();
+	}
+}
+
+
+/*
+ * Function:	generateFunctions
+ *
+ * Description:	Generate the given functions on a pool of threads, then
+ *		write out their code in the order given.  The output is the
+ *		same as generating them one after another.
+ */
+
+void generateFunctions(const Functions &functions, unsigned jobs)
+{
+	vector<string> buffers(functions.size());
+	vector<thread> workers;
+	atomic<unsigned> next(0);
+
+	for(unsigned i = 1; i < jobs && i < functions.size(); i ++)
+		workers.push_back(thread(generateFunction, compiler, &functions, &buffers, &next));
+
+	generateFunction(compiler, &functions, &buffers, &next);
+
+	for(unsigned i = 0; i < workers.size(); i ++)
+		workers[i].join();
+
+	for(unsigned i = 0; i < buffers.size(); i ++)
+		*compiler->out << buffers[i];
+}
+
+
+/*
+ * Function:	generateFile
+ *
+ * Description:	With -g, name the source as file 1 of the line table, to
+ *		which the lines of the statements refer.
+ */
+
+void generateFile()
+{
+	*compiler->out << "\t.file\t1 \"" << compiler->options.sourceName << "\"" << endl;
+}
+
+
+/*
+ * Function:	generateGlobals
+ *
+ * Description:	Generate code for any global variable declarations.
+ */
+
+void generateGlobals(const Symbols &globals)
+{
+	ostream &out = *compiler->out;
+
+	if (globals.size() > 0)
+		out << "\t.data" << endl;
+
+	for (unsigned i = 0; i < globals.size(); i ++) {
+		out << "\t.comm\t" << global_prefix << globals[i]->name();
+		out << ", " << globals[i]->type().size();
+		out << ", " << globals[i]->type().alignment() << endl;
+	}
+}
+
+/*
+ * Function:	generateStrings
+ *
+ * Description:	Generate the string literal pool.  Longer strings are laid
+ *		out first, and a string that is a suffix of one already
+ *		laid out becomes a label inside it, since both share the
+ *		same terminating null byte.
+ */
+
+static void generateStringLabels(const set<string> &labels)
+{
+	ostream &out = *compiler->out;
+	set<string>::const_iterator it;
+
+	for (it = labels.begin(); it != labels.end(); it ++)
+		out << *it << ":" << endl;
+}
+
+void generateStrings()
+{
+	ostream &out = *compiler->out;
+	map<string, set<string> > &strings = compiler->strings;
+	vector<string> order;
+	map<string, vector<string> > suffixes;
+	map<string, set<string> >::iterator it;
+
+	if (strings.size() > 0)
+		out << "\t.section\t.rodata" << endl;
+
+	for (it = strings.begin(); it != strings.end(); it ++)
+		order.push_back(it->first);
+
+	stable_sort(order.begin(), order.end(), longerString);
+
+	for (unsigned i = 0; i < order.size(); i ++) {
+		unsigned j;
+
+		for (j = 0; j < i; j ++)
+			if (suffixes.count(order[j]) > 0 && isSuffix(order[i], order[j]))
+				break;
+
+		if (j < i)
+			suffixes[order[j]].push_back(order[i]);
+		else
+			suffixes[order[i]];
+	}
+
+	for (unsigned i = 0; i < order.size(); i ++) {
+		if (suffixes.count(order[i]) == 0)
+			continue;
+
+		const string &root = order[i];
+		const vector<string> &shared = suffixes[root];
+		unsigned start = 0;
+
+		generateStringLabels(strings[root]);
+
+		for (unsigned j = 0; j < shared.size(); j ++) {
+			unsigned at = root.size() - shared[j].size();
+
+			if (at > start)
+				out << "\t.ascii\t" << encodeString(root.substr(start, at - start)) << endl;
+
+			generateStringLabels(strings[shared[j]]);
+			start = at;
+		}
+
+		out << "\t.asciz\t" << encodeString(root.substr(start)) << endl;
+	}
+}
+
+/*
+ * Function: Add::generate
+ * 
+ * Description: Generate "addition" ASM code
+ *
+ */
+
+void Add::generate()
+{
+	TIME("generate Add");
+
+	//Pointer arithmetic is done at the size of a pointer
+	unsigned size = width(_left, _right);
+	string right;
+
+	//Do other generations first
+	_left -> generate();
+	_right -> generate();
+
+	//Generate Temp Variable Offset
+	assignTempOffset(this);
+
+	//Load Op Store
+	load(_left, "ax", size);
+	right = source(_right, size);
+	context->out << "\t" << op("add", size) << "\t" << right << ", " << reg("ax", size) << endl;
+	context->out << "\t" << op("mov", _type.size()) << "\t" << reg("ax", _type.size()) << ", " << this << endl;
+}
+
+/*
+ * Function: Subtract::generate
+ *
+ * Description: Generate "subtraction" ASM code
+ *
+ */
+
+void Subtract::generate()
+{
+	TIME("generate Subtract");
+
+	//Pointer arithmetic is done at the size of a pointer
+	unsigned size = width(_left, _right);
+	string right;
+
+	//Do other generations first
+	_left -> generate();
+	_right -> generate();
+
+	//Generate Temp Variable Offset
+	assignTempOffset(this);
+
+	//Load Op Store
+	load(_left, "ax", size);
+	right = source(_right, size);
+	context->out << "\t" << op("sub", size) << "\t" << right << ", " << reg("ax", size) << endl;
+	context->out << "\t" << op("mov", _type.size()) << "\t" << reg("ax", _type.size()) << ", " << this << endl;
+}
+/*
+ * Function: scaleByConstant
+ *
+ * Description: Multiply %eax in place by a non-negative constant.  The
+ *		constant is split into m * 2^k with m odd; powers of two
+ *		become a shift, and m of 3, 5, 9 or a product of two of
+ *		those becomes one or two leal instructions.  Anything else
+ *		falls back to an immediate imull.
+ */
+
+static void scaleByConstant(long value)
+{
+	static const long leaFactors[] = {9, 5, 3};
+	long m = value, factors[2];
+	unsigned i, k = 0, count = 0;
+
+	if(value == 0)
+	{
+		context->out << "\tmovl\t$0, %eax" << endl;
+		return;
+	}
+
+	//Split into m * 2^k
+	while(m % 2 == 0)
+	{
+		m /= 2;
+		k ++;
+	}
+
+	//Odd part through at most two leal (%eax,%eax,n-1)
+	for(i = 0; i < 3 && count < 2 && m > 1; )
+		if(m % leaFactors[i] == 0)
+		{
+			factors[count ++] = leaFactors[i];
+			m /= leaFactors[i];
+		}
+		else
+			i ++;
+
+	if(m != 1)
+	{
+		context->out << "\timull\t$" << value << ", %eax" << endl;
+		return;
+	}
+
+	for(i = 0; i < count; i ++)
+		context->out << "\tleal\t(" << reg("ax", SIZEOF_PTR) << "," << reg("ax", SIZEOF_PTR) << "," << factors[i] - 1 << "), %eax" << endl;
+
+	if(k > 0)
+		context->out << "\tsall\t$" << k << ", %eax" << endl;
+}
+
+/*
+ * Function: computeMagic
+ *
+ * Description: Compute the magic multiplier and shift for signed
+ *		division by a constant d >= 2 (Hacker's Delight, 10-1).
+ */
+
+static void computeMagic(long d, int &multiplier, unsigned &shift)
+{
+	const unsigned two31 = 0x80000000u;
+	unsigned ad = d, anc, q1, r1, q2, r2, delta;
+	int p = 31;
+
+	anc = two31 - 1 - two31 % ad;
+	q1 = two31 / anc;
+	r1 = two31 - q1 * anc;
+	q2 = two31 / ad;
+	r2 = two31 - q2 * ad;
+
+	do {
+		p ++;
+		q1 = 2 * q1;
+		r1 = 2 * r1;
+
+		if(r1 >= anc)
+		{
+			q1 ++;
+			r1 -= anc;
+		}
+
+		q2 = 2 * q2;
+		r2 = 2 * r2;
+
+		if(r2 >= ad)
+		{
+			q2 ++;
+			r2 -= ad;
+		}
+
+		delta = ad - r2;
+	} while(q1 < delta || (q1 == delta && r1 == 0));
+
+	multiplier = (int) (q2 + 1);
+	shift = p - 32;
 }
 
 /*
- * Function: Add::generate
- * 
- * Description: Generate "addition" ASM code
+ * Function: divideByConstant
  *
+ * Description: Leave the quotient of the expression divided by a
+ *		positive constant in %eax, rounding toward zero as idivl
+ *		would.  Powers of two are biased and shifted; other
+ *		divisors use a magic-number multiply.  Clobbers %ecx and
+ *		%edx.
  */
 
-void Add::generate()
+static void divideByConstant(Expression *expr, long value)
 {
-	//Do other generations first
-	_left -> generate();
-	_right -> generate();
+	int multiplier;
+	unsigned k, shift;
 
-	//Generate Temp Variable Offset
-	assignTempOffset(this);
+	//Load
+	context->out << "\tmovl\t" << expr << ", %eax" << endl;
 
-	//Load Op Store
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
-	cout << "\taddl\t" << _right << ", %eax" << endl;
-	cout << "\tmovl\t%eax, " << this << endl;
-}
+	if(value == 1)
+		return;
 
-/*
- * Function: Subtract::generate
- *
- * Description: Generate "subtraction" ASM code
- *
- */
+	//Power of two: add (2^k - 1) to negative dividends, then shift
+	if((value & (value - 1)) == 0)
+	{
+		for(k = 0; (1L << k) < value; k ++)
+			;
+
+		context->out << "\tcltd\t" << endl;
+		context->out << "\tandl\t$" << value - 1 << ", %edx" << endl;
+		context->out << "\taddl\t%edx, %eax" << endl;
+		context->out << "\tsarl\t$" << k << ", %eax" << endl;
+		return;
+	}
 
-void Subtract::generate()
-{
-	//Do other generations first
-	_left -> generate();
-	_right -> generate();
+	//Magic number: high half of the product, corrected for the sign
+	computeMagic(value, multiplier, shift);
 
-	//Generate Temp Variable Offset
-	assignTempOffset(this);
+	context->out << "\tmovl\t%eax, %ecx" << endl;
+	context->out << "\tmovl\t$" << multiplier << ", %eax" << endl;
+	context->out << "\timull\t%ecx" << endl;
 
-	//Load Op Store
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
-	cout << "\tsubl\t" << _right << ", %eax" << endl;
-	cout << "\tmovl\t%eax, " << this << endl;
+	if(multiplier < 0)
+		context->out << "\taddl\t%ecx, %edx" << endl;
+
+	if(shift > 0)
+		context->out << "\tsarl\t$" << shift << ", %edx" << endl;
+
+	context->out << "\tmovl\t%ecx, %eax" << endl;
+	context->out << "\tshrl\t$31, %eax" << endl;
+	context->out << "\taddl\t%edx, %eax" << endl;
 }
+
 /*
  * Function: Multiply::generate
  *
- * Description: Generate "multiplication" ASM code
+ * Description: Generate "multiplication" ASM code.  Multiplication by
+ *		a constant, which is how the checker scales array indices
+ *		and pointer arithmetic, is strength reduced.
  *
  */
 
 void Multiply::generate()
 {
+	TIME("generate Multiply");
+
+	long value;
+
 	//Do other generations first
 	_left -> generate();
 	_right -> generate();
@@ -439,20 +1739,40 @@ void Multiply::generate()
 	assignTempOffset(this);
 
 	//Load Op Store
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
-	cout << "\timull\t" << _right << ", %eax" << endl;
-	cout << "\tmovl\t%eax, " << this << endl;
+	if(isConstant(_right, value))
+	{
+		context->out << "\tmovl\t" << _left << ", %eax" << endl;
+		scaleByConstant(value);
+	}
+	else if(isConstant(_left, value))
+	{
+		context->out << "\tmovl\t" << _right << ", %eax" << endl;
+		scaleByConstant(value);
+	}
+	else
+	{
+		context->out << "\tmovl\t" << _left << ", %eax" << endl;
+		context->out << "\timull\t" << _right << ", %eax" << endl;
+	}
+
+	context->out << "\tmovl\t%eax, " << this << endl;
 }
 
 /*
  * Function: Divide::generate
  *
- * Description: Generate "division" ASM code
+ * Description: Generate "division" ASM code.  Division by a positive
+ *		constant, such as the element size in a pointer difference,
+ *		avoids idivl.
  *
  */
 
 void Divide::generate()
 {
+	TIME("generate Divide");
+
+	long value;
+
 	//Do other generations first
 	_left -> generate();
 	_right -> generate();
@@ -460,27 +1780,40 @@ void Divide::generate()
 	//Generate Temp Variable Offset
 	assignTempOffset(this);
 
-	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
-	cout << "\tmovl\t" << _right << ", %ecx" << endl;
+	if(isConstant(_right, value) && value > 0)
+	{
+		//Op (%eax contains result)
+		divideByConstant(_left, value);
+	}
+	else
+	{
+		//Load
+		context->out << "\tmovl\t" << _left << ", %eax" << endl;
+		context->out << "\tmovl\t" << _right << ", %ecx" << endl;
 
-	//Op
-	cout << "\tcltd\t" << endl;
-	cout << "\tidivl\t%ecx " << endl;
+		//Op
+		context->out << "\tcltd\t" << endl;
+		context->out << "\tidivl\t%ecx " << endl;
+	}
 
 	//Store (%eax contains result)
-	cout << "\tmovl\t%eax, " << this << endl; 
+	context->out << "\tmovl\t%eax, " << this << endl; 
 }
 
 /*
  * Function: Remainder::generate
  *
- * Description: Generate "modulo" or "remainder"  ASM code
+ * Description: Generate "modulo" or "remainder"  ASM code.  Remainder
+ *		by a positive constant is computed as x - (x / c) * c.
  *
  */
 
 void Remainder::generate()
 {
+	TIME("generate Remainder");
+
+	long value;
+
 	//Do other generations first
 	_left -> generate();
 	_right -> generate();
@@ -488,16 +1821,28 @@ void Remainder::generate()
 	//Generate Temp Variable Offset
 	assignTempOffset(this);
 
-	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
-	cout << "\tmovl\t" << _right << ", %ecx" << endl;
+	if(isConstant(_right, value) && value > 0)
+	{
+		//Op (%eax contains quotient)
+		divideByConstant(_left, value);
+		scaleByConstant(value);
+
+		context->out << "\tmovl\t" << _left << ", %edx" << endl;
+		context->out << "\tsubl\t%eax, %edx" << endl;
+	}
+	else
+	{
+		//Load
+		context->out << "\tmovl\t" << _left << ", %eax" << endl;
+		context->out << "\tmovl\t" << _right << ", %ecx" << endl;
 
-	//Op
-	cout << "\tcltd\t" << endl;
-	cout << "\tidivl\t%ecx " << endl;
+		//Op
+		context->out << "\tcltd\t" << endl;
+		context->out << "\tidivl\t%ecx " << endl;
+	}
 
-	//Store (%ecx contains remainder)
-	cout << "\tmovl\t%edx, " << this << endl; 
+	//Store (%edx contains remainder)
+	context->out << "\tmovl\t%edx, " << this << endl; 
 }
 
 /*
@@ -508,6 +1853,12 @@ void Remainder::generate()
 
 void LessThan::generate()
 {
+	TIME("generate LessThan");
+
+	//Pointers are compared whole
+	unsigned size = width(_left, _right);
+	string right;
+
 	//Do other generations
 	_left -> generate();
 	_right -> generate();
@@ -516,19 +1867,20 @@ void LessThan::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
+	load(_left, "ax", size);
 
 	//Start Op
-	cout << "\tcmpl\t" << _right << ", %eax" << endl;
+	right = source(_right, size);
+	context->out << "\t" << op("cmp", size) << "\t" << right << ", " << reg("ax", size) << endl;
 
 	//This is the only line that changes amongst the Comparison statments
-	cout << "\tsetl %al" << endl;
+	context->out << "\tsetl %al" << endl;
 
-	cout << "\tmovzbl %al, %eax" << endl;
+	context->out << "\tmovzbl %al, %eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl %eax, " << this << endl;
+	context->out << "\tmovl %eax, " << this << endl;
 }
 
 /*
@@ -539,6 +1891,12 @@ void LessThan::generate()
 
 void GreaterThan::generate()
 {
+	TIME("generate GreaterThan");
+
+	//Pointers are compared whole
+	unsigned size = width(_left, _right);
+	string right;
+
 	//Do other generations
 	_left -> generate();
 	_right -> generate();
@@ -547,19 +1905,20 @@ void GreaterThan::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
+	load(_left, "ax", size);
 
 	//Start Op
-	cout << "\tcmpl\t" << _right << ", %eax" << endl;
+	right = source(_right, size);
+	context->out << "\t" << op("cmp", size) << "\t" << right << ", " << reg("ax", size) << endl;
 
 	//This is the only line that changes amongst the Comparison statments
-	cout << "\tsetg %al" << endl;
+	context->out << "\tsetg %al" << endl;
 
-	cout << "\tmovzbl %al, %eax" << endl;
+	context->out << "\tmovzbl %al, %eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl %eax, " << this << endl;
+	context->out << "\tmovl %eax, " << this << endl;
 }
 
 /*
@@ -570,6 +1929,12 @@ void GreaterThan::generate()
 
 void LessOrEqual::generate()
 {
+	TIME("generate LessOrEqual");
+
+	//Pointers are compared whole
+	unsigned size = width(_left, _right);
+	string right;
+
 	//Do other generations
 	_left -> generate();
 	_right -> generate();
@@ -578,19 +1943,20 @@ void LessOrEqual::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
+	load(_left, "ax", size);
 
 	//Start Op
-	cout << "\tcmpl\t" << _right << ", %eax" << endl;
+	right = source(_right, size);
+	context->out << "\t" << op("cmp", size) << "\t" << right << ", " << reg("ax", size) << endl;
 
 	//This is the only line that changes amongst the Comparison statments
-	cout << "\tsetle %al" << endl;
+	context->out << "\tsetle %al" << endl;
 
-	cout << "\tmovzbl %al, %eax" << endl;
+	context->out << "\tmovzbl %al, %eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl %eax, " << this << endl;
+	context->out << "\tmovl %eax, " << this << endl;
 }
 
 /*
@@ -601,6 +1967,12 @@ void LessOrEqual::generate()
 
 void GreaterOrEqual::generate()
 {
+	TIME("generate GreaterOrEqual");
+
+	//Pointers are compared whole
+	unsigned size = width(_left, _right);
+	string right;
+
 	//Do other generations
 	_left -> generate();
 	_right -> generate();
@@ -609,19 +1981,20 @@ void GreaterOrEqual::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
+	load(_left, "ax", size);
 
 	//Start Op
-	cout << "\tcmpl\t" << _right << ", %eax" << endl;
+	right = source(_right, size);
+	context->out << "\t" << op("cmp", size) << "\t" << right << ", " << reg("ax", size) << endl;
 
 	//This is the only line that changes amongst the Comparison statments
-	cout << "\tsetge %al" << endl;
+	context->out << "\tsetge %al" << endl;
 
-	cout << "\tmovzbl %al, %eax" << endl;
+	context->out << "\tmovzbl %al, %eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl %eax, " << this << endl;
+	context->out << "\tmovl %eax, " << this << endl;
 }
 
 /*
@@ -632,6 +2005,12 @@ void GreaterOrEqual::generate()
 
 void Equal::generate()
 {
+	TIME("generate Equal");
+
+	//Pointers are compared whole
+	unsigned size = width(_left, _right);
+	string right;
+
 	//Do other generations
 	_left -> generate();
 	_right -> generate();
@@ -640,19 +2019,20 @@ void Equal::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
+	load(_left, "ax", size);
 
 	//Start Op
-	cout << "\tcmpl\t" << _right << ", %eax" << endl;
+	right = source(_right, size);
+	context->out << "\t" << op("cmp", size) << "\t" << right << ", " << reg("ax", size) << endl;
 
 	//This is the only line that changes amongst the Comparison statments
-	cout << "\tsete\t%al" << endl;
+	context->out << "\tsete\t%al" << endl;
 
-	cout << "\tmovzbl\t%al, %eax" << endl;
+	context->out << "\tmovzbl\t%al, %eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << "\tmovl\t%eax, " << this << endl;
 }
 
 /*
@@ -663,6 +2043,12 @@ void Equal::generate()
 
 void NotEqual::generate()
 {
+	TIME("generate NotEqual");
+
+	//Pointers are compared whole
+	unsigned size = width(_left, _right);
+	string right;
+
 	//Do other generations
 	_left -> generate();
 	_right -> generate();
@@ -671,19 +2057,20 @@ void NotEqual::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _left << ", %eax" << endl;
+	load(_left, "ax", size);
 
 	//Start Op
-	cout << "\tcmpl\t" << _right << ", %eax" << endl;
+	right = source(_right, size);
+	context->out << "\t" << op("cmp", size) << "\t" << right << ", " << reg("ax", size) << endl;
 
 		//This is the only line that changes amongst the Comparison statments
-		cout << "\tsetne\t%al" << endl;
+		context->out << "\tsetne\t%al" << endl;
 
-	cout << "\tmovzbl\t%al, %eax" << endl;
+	context->out << "\tmovzbl\t%al, %eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << "\tmovl\t%eax, " << this << endl;
 }
 
 /*
@@ -694,6 +2081,8 @@ void NotEqual::generate()
 
 void Not::generate()
 {
+	TIME("generate Not");
+
 	//Do other generations
 	_expr -> generate();
 	
@@ -701,16 +2090,16 @@ void Not::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _expr << ", %eax" << endl;
+	load(_expr, "ax", _expr->type().size());
 
 	//Start Op
-	cout << "\tcmpl\t $0" << ", %eax" << endl;
-	cout << "\tsete\t%al" << endl;
-	cout << "\tmovzbl\t%al, %eax" << endl;
+	context->out << "\t" << op("cmp", _expr->type().size()) << "\t $0" << ", " << reg("ax", _expr->type().size()) << endl;
+	context->out << "\tsete\t%al" << endl;
+	context->out << "\tmovzbl\t%al, %eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << "\tmovl\t%eax, " << this << endl;
 }
 
 /*
@@ -721,6 +2110,8 @@ void Not::generate()
 
 void Negate::generate()
 {
+	TIME("generate Negate");
+
 	//Do other generations
 	_expr -> generate();
 	
@@ -728,14 +2119,14 @@ void Negate::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _expr << ", %eax" << endl;
+	context->out << "\tmovl\t" << _expr << ", %eax" << endl;
 
 	//Start Op
-	cout << "\tnegl\t%eax" << endl;
+	context->out << "\tnegl\t%eax" << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << "\tmovl\t%eax, " << this << endl;
 }
 
 /*
@@ -745,6 +2136,8 @@ void Negate::generate()
  */
 void Cast::generate()
 {
+	TIME("generate Cast");
+
 	// .type() will return the new type
 		Type src = _expr->type();
 		Type dest = this->type();
@@ -760,44 +2153,56 @@ void Cast::generate()
 	if(dest.size() == 4 && src.size() == 1)
 	{
 		//Load Byte
-		cout << "\tmovb\t" << _expr << ", %al" << endl;
+		context->out << "\tmovb\t" << _expr << ", %al" << endl;
 		
 		//Op
-		cout << "\tmovsbl\t%al, %eax" << endl;
+		context->out << "\tmovsbl\t%al, %eax" << endl;
 
 		//Store into Long
-		cout << "\tmovl\t%eax, " << this << endl;
+		context->out << "\tmovl\t%eax, " << this << endl;
 	}
 	
-	//If Dest Size == 1 and Src Size == 1 
-	else if(dest.size() == 1 && src.size() == 4)
+	//If Dest Size == 1 and Src Size == 4 or 8
+	else if(dest.size() == 1 && src.size() >= 4)
 	{
 		//Load Long
-		cout << "\tmovl\t" << _expr << ", %eax" << endl;
+		context->out << "\tmovl\t" << _expr << ", %eax" << endl;
 		//Op
 		//Do Nothing
 		//Store into Byte
-		cout << "\tmovb\t %al, " << this << endl;
+		context->out << "\tmovb\t %al, " << this << endl;
 	}
 	//If Dest Size == 1 and Src Size == 1
 	else if(dest.size() == 1 && src.size() == 1)
 	{
 		//Load Byte
-		cout << "\tmovb\t" << _expr << ", %al" << endl;
+		context->out << "\tmovb\t" << _expr << ", %al" << endl;
 		//Op
 		//Do Nothing
 		//Store into Byte
-		cout << "\tmovb\t%al, " << this << endl;
+		context->out << "\tmovb\t%al, " << this << endl;
 	}
-	//If Dest Size == 4 and Src Size == 4
-	else if(dest.size() == 4 && src.size() == 4)
+	//If Dest Size == 4 and Src Size == 4 or 8
+	else if(dest.size() == 4 && src.size() >= 4)
 	{
 		//Load Long
-		cout << "\tmovl\t" << _expr << ", %eax" << endl;
+		context->out << "\tmovl\t" << _expr << ", %eax" << endl;
 		//Op
 		//Do Nothing
 		//Store into Long
-		cout << "\tmovl\t%eax, " << this << endl;
+		context->out << "\tmovl\t%eax, " << this << endl;
+	}
+	//If Dest Size == 8, a pointer on x86-64
+	else if(dest.size() == 8)
+	{
+		//Load and Sign Extend
+		if(src.size() == 1 && !isImmediate(_expr))
+			context->out << "\tmovsbq\t" << _expr << ", %rax" << endl;
+		else
+			load(_expr, "ax", 8);
+
+		//Store into Quad
+		context->out << "\tmovq\t%rax, " << this << endl;
 	}
 	else
 	{
@@ -814,6 +2219,8 @@ void Cast::generate()
 
 void Return::generate()
 {
+	TIME("generate Return");
+
 	//
 	//By Covention, return values are stored in %eax
 	//
@@ -826,14 +2233,61 @@ void Return::generate()
 	//Unnecessry, Return is a statment not an expression
 	
 	//Load
-	cout << "\tmovl\t" << _expr << ", %eax" << endl;
-	//Op
-	cout << "\tjmp\t" << *returnLabel  << endl; 
+	load(_expr, "ax", _expr->type().size());
+	//Op, unless the epilogue comes next anyway
+	if(this != context->lastStatement)
+		context->out << "\tjmp\t" << *context->returnLabel  << endl; 
 	//Store
 	//Do nothing, temp variable is already in %eax
 	//_expr -> _operand = "%eax";
 }
 
+/*
+ * Function: rotateLoop
+ *
+ * Description: Decide whether the loop about to be generated should have
+ *		its test at the bottom, where each iteration needs only the
+ *		one jump back, at the price of a jump to the test on entry.
+ *		That pays when the profile shows the body entered at least
+ *		as often as the loop.  The block counting entries to the
+ *		loop is counted here if so.
+ */
+
+static bool rotateLoop()
+{
+	unsigned entry = context->blocks;
+
+	if(context->counts == nullptr || blockCount(entry + 1) == 0)
+		return false;
+
+	if(blockCount(entry + 1) < blockCount(entry))
+		return false;
+
+	countBlock();
+	return true;
+}
+
+/*
+ * Function: generateTest
+ *
+ * Description: Generate the test of a rotated loop and return its code,
+ *		to be placed after the body.  The test is still generated
+ *		first, as it runs first, since the body may reuse the
+ *		values it computes.
+ */
+
+static string generateTest(Expression *expr)
+{
+	stringstream test;
+	streambuf *saved = context->out.rdbuf(test.rdbuf());
+
+	expr -> generate();
+	compareToZero(expr);
+
+	context->out.rdbuf(saved);
+	return test.str();
+}
+
 /*
  * Function: While::generate
  *
@@ -842,26 +2296,198 @@ void Return::generate()
 
 void While::generate()
 {
+	TIME("generate While");
+
 	//Create new Labels
 	Label topOfLoop;
 	Label exitLoop;
 
-	cout << topOfLoop << ":" << endl;
+	//A loop that usually iterates has its test at the bottom
+	if(rotateLoop())
+	{
+		Label test;
+		string code = generateTest(_expr);
+
+		context->out << "\tjmp\t" << test << endl;
+		context->out << topOfLoop << ":" << endl;
+
+		context->breakLabels.push_back(exitLoop);
+		countBlock();
+		generateLine(_stmt);
+		_stmt -> generate();
+		context->breakLabels.pop_back();
+
+		context->out << test << ":" << endl;
+		generateLine(this);
+		context->out << code;
+		context->out << "\tjne\t" << topOfLoop << endl;
+		context->out << exitLoop << ":" << endl;
+		return;
+	}
+
+	//Count entries to the loop, then iterations
+	countBlock();
+	context->out << topOfLoop << ":" << endl;
 	//Do other generations
 	_expr -> generate();
 
 	//Start Loop and Make Conditional Check
-	cout << "\tcmpl\t$0, " << _expr << endl;
+	compareToZero(_expr);
 	//Jump if equal
-	cout << "\tje\t" << exitLoop << endl;
+	context->out << "\tje\t" << exitLoop << endl;
 
-	//Generate _stmt
+	//Generate _stmt, with break leaving the loop
+	context->breakLabels.push_back(exitLoop);
+	countBlock();
+	generateLine(_stmt);
 	_stmt -> generate();
+	context->breakLabels.pop_back();
 	//Jump back to top
-	cout << "\tjmp\t" << topOfLoop << endl;
+	context->out << "\tjmp\t" << topOfLoop << endl;
+
+	//Print out exit label
+	context->out << exitLoop << ":" << endl;
+}
+
+/*
+ * Function: For::generate
+ *
+ * Description: Generate "for" control flow operator ASM code.  With
+ *		-funroll-loops, a counted loop runs its body and increment
+ *		unrollFactor times per test, followed by a remainder.  If
+ *		the trip count is a constant no larger than the factor, the
+ *		loop disappears entirely.
+ */
+
+void For::generate()
+{
+	TIME("generate For");
+
+	const unsigned unrollFactor = compiler->options.unrollFactor;
+
+	//Create new Labels
+	Label topOfLoop;
+	Label exitLoop;
+	CountedLoop loop;
+
+	//Do other generations
+	if(_init != nullptr)
+		_init -> generate();
+
+	//Break leaves the loop
+	context->breakLabels.push_back(exitLoop);
+
+	if(unrollFactor > 1 && isCountedLoop(_init, _expr, _incr, _stmt, loop) &&
+		labs(loop.stride) <= INT_MAX / unrollFactor)
+	{
+		Label remainder;
+		Expression *guard;
+		long copies;
+
+		//The copies of an unrolled body are not counted
+		countBlock(false);
+		countBlock(false);
+
+		if(loop.constant && loop.trips <= unrollFactor)
+			copies = loop.trips;
+		else
+		{
+			//Unrolled loop, while the test passes and unrollFactor
+			//iterations remain
+			guard = unrollGuard(loop, unrollFactor);
+
+			context->out << topOfLoop << ":" << endl;
+			_expr -> generate();
+			compareToZero(_expr);
+			context->out << "\tje\t" << exitLoop << endl;
+			guard -> generate();
+			compareToZero(guard);
+			context->out << "\tje\t" << remainder << endl;
+
+			for(unsigned i = 0; i < unrollFactor; i ++)
+			{
+				generateLine(_stmt);
+				_stmt -> generate();
+				_incr -> generate();
+			}
+
+			context->out << "\tjmp\t" << topOfLoop << endl;
+			context->out << remainder << ":" << endl;
+
+			copies = (loop.constant ? loop.trips % unrollFactor : -1);
+		}
+
+		//Straight-line remainder if the count is known
+		for(long i = 0; i < copies; i ++)
+		{
+			generateLine(_stmt);
+			_stmt -> generate();
+			_incr -> generate();
+		}
+
+		//Otherwise the original loop finishes up
+		if(copies < 0)
+		{
+			_expr -> generate();
+			compareToZero(_expr);
+			context->out << "\tje\t" << exitLoop << endl;
+			generateLine(_stmt);
+			_stmt -> generate();
+			_incr -> generate();
+			context->out << "\tjmp\t" << remainder << endl;
+		}
+	}
+	else if(_expr != nullptr && rotateLoop())
+	{
+		Label test;
+		string code = generateTest(_expr);
+
+		//A loop that usually iterates has its test at the bottom
+		context->out << "\tjmp\t" << test << endl;
+		context->out << topOfLoop << ":" << endl;
+
+		countBlock();
+		generateLine(_stmt);
+		_stmt -> generate();
+
+		if(_incr != nullptr)
+			_incr -> generate();
+
+		context->out << test << ":" << endl;
+		generateLine(this);
+		context->out << code;
+		context->out << "\tjne\t" << topOfLoop << endl;
+	}
+	else
+	{
+		//Count entries to the loop, then iterations
+		countBlock();
+		context->out << topOfLoop << ":" << endl;
+
+		//Start Loop and Make Conditional Check
+		if(_expr != nullptr)
+		{
+			_expr -> generate();
+			compareToZero(_expr);
+			context->out << "\tje\t" << exitLoop << endl;
+		}
+
+		//Generate _stmt and _incr
+		countBlock();
+		generateLine(_stmt);
+		_stmt -> generate();
+
+		if(_incr != nullptr)
+			_incr -> generate();
+
+		//Jump back to top
+		context->out << "\tjmp\t" << topOfLoop << endl;
+	}
+
+	context->breakLabels.pop_back();
 
 	//Print out exit label
-	cout << exitLoop << ":" << endl;
+	context->out << exitLoop << ":" << endl;
 }
 
 /*
@@ -872,6 +2498,8 @@ void While::generate()
 
 void If::generate()
 {
+	TIME("generate If");
+
 	//Create new Labels
 	Label skipTrue;
 	Label exitIfElse;
@@ -880,35 +2508,254 @@ void If::generate()
 	_expr -> generate();
 
 	//Make check against false (same regardless of existence of else statement)
-	cout << "\tcmpl\t$0, " << _expr << endl;
-	cout << "\tje\t" << skipTrue << endl;
+	compareToZero(_expr);
+
+	//With a profile, the arm entered more often falls through
+	if(context->counts != nullptr)
+	{
+		unsigned thenBlock = context->blocks;
+		string thenCode = generateArm(_thenStmt);
+		unsigned elseBlock = context->blocks;
+		string elseCode = generateArm(_elseStmt);
+		unsigned long long thenCount = blockCount(thenBlock);
+		unsigned long long elseCount = blockCount(elseBlock);
+
+		if(thenCount >= elseCount)
+			placeArms("je", thenCode, elseCode, elseCount * COLD_RATIO <= thenCount && thenCount > 0);
+		else
+			placeArms("jne", elseCode, thenCode, thenCount * COLD_RATIO <= elseCount);
+
+		return;
+	}
+
+	context->out << "\tje\t" << skipTrue << endl;
 
 	//If *_elseStmt == nullptr, then there is no else statement
 	if(_elseStmt == nullptr)
 	{
 		//Generate _thenStmt
+		countBlock();
+		generateLine(_thenStmt);
 		_thenStmt -> generate();
+
+		//A counted false path needs code of its own
+		if(compiler->options.instrument)
+			context->out << "\tjmp\t" << exitIfElse << endl;
+
 		//Print Label Skip to skip over the then statement
-		cout << skipTrue << ":" << endl;
+		context->out << skipTrue << ":" << endl;
+		countBlock();
+
+		if(compiler->options.instrument)
+			context->out << exitIfElse << ":" << endl;
 	}
 	//Else there is an else statement
 	else
 	{
 		//Generate _thenStmt
+		countBlock();
+		generateLine(_thenStmt);
 		_thenStmt -> generate();
 
 		//Jump to Exit (and over the else code)
-		cout << "\tjmp\t" << exitIfElse << endl;
+		context->out << "\tjmp\t" << exitIfElse << endl;
 
 		//Print Label Skip to skip over the then statement to move to else statement
-		cout << skipTrue << ":" << endl;
+		context->out << skipTrue << ":" << endl;
 
 		//Generate _elseStmt
+		countBlock();
+		generateLine(_elseStmt);
 		_elseStmt -> generate();
 
 		//Print Label Exit to skip over the else statement if then was executed
-		cout<< exitIfElse << ":" << endl;
+		context->out << exitIfElse << ":" << endl;
+	}
+}
+
+/*
+ * Function: lowerCase
+ *
+ * Description: Order case labels by value for the switch dispatch.
+ */
+
+static bool lowerCase(Case *a, Case *b)
+{
+	return a->value() < b->value();
+}
+
+/*
+ * Function: generateDecisionTree
+ *
+ * Description: Dispatch on %eax over the sorted cases in [lo, hi) by
+ *		binary search.  A handful of cases is just a compare chain,
+ *		which is also what a small switch gets as a whole.
+ */
+
+static void generateDecisionTree(const vector<Case *> &cases, unsigned lo, unsigned hi, const string &otherwise)
+{
+	unsigned mid;
+
+	if(hi - lo <= MAX_CHAIN_CASES)
+	{
+		for(unsigned i = lo; i < hi; i ++)
+		{
+			context->out << "\tcmpl\t$" << cases[i]->value() << ", %eax" << endl;
+			context->out << "\tje\t" << cases[i]->_label << endl;
+		}
+
+		context->out << "\tjmp\t" << otherwise << endl;
+		return;
+	}
+
+	Label lower;
+	mid = (lo + hi) / 2;
+
+	context->out << "\tcmpl\t$" << cases[mid]->value() << ", %eax" << endl;
+	context->out << "\tje\t" << cases[mid]->_label << endl;
+	context->out << "\tjl\t" << lower << endl;
+
+	generateDecisionTree(cases, mid + 1, hi, otherwise);
+
+	context->out << lower << ":" << endl;
+	generateDecisionTree(cases, lo, mid, otherwise);
+}
+
+/*
+ * Function: generateJumpTable
+ *
+ * Description: Dispatch on %eax through a table in .rodata indexed by
+ *		the value less the smallest case.  Values outside the table
+ *		go to the default with a single unsigned compare.  Position
+ *		independent code cannot hold absolute addresses in .rodata,
+ *		so there each entry is the distance of its case from the
+ *		table instead.
+ */
+
+static void generateJumpTable(const vector<Case *> &cases, const string &otherwise)
+{
+	Label table;
+	long min = cases.front()->value(), max = cases.back()->value();
+	unsigned next = 0;
+	stringstream relative;
+
+	if(min != 0)
+		context->out << "\tsubl\t$" << min << ", %eax" << endl;
+
+	context->out << "\tcmpl\t$" << max - min << ", %eax" << endl;
+	context->out << "\tja\t" << otherwise << endl;
+
+	if(machine().positionIndependent)
+	{
+		context->out << "\tleaq\t" << table << "(%rip), %rdx" << endl;
+		context->out << "\tmovslq\t(%rdx,%rax,4), %rax" << endl;
+		context->out << "\taddq\t%rdx, %rax" << endl;
+		context->out << "\tjmp\t*%rax" << endl;
+		relative << "-" << table;
+	}
+	else
+		context->out << "\tjmp\t*" << table << "(,%eax," << SIZEOF_PTR << ")" << endl;
+
+	context->out << "\t.section\t.rodata" << endl;
+	context->out << "\t.align\t" << ALIGNOF_PTR << endl;
+	context->out << table << ":" << endl;
+
+	for(long value = min; value <= max; value ++)
+		if(cases[next]->value() == value)
+			context->out << "\t.long\t" << cases[next ++]->_label << relative.str() << endl;
+		else
+			context->out << "\t.long\t" << otherwise << relative.str() << endl;
+
+	context->out << "\t.text" << endl;
+}
+
+/*
+ * Function: Switch::generate
+ *
+ * Description: Generate "switch" control flow operator ASM code.  The
+ *		dispatch is a jump table if the cases are dense enough, a
+ *		binary decision tree if there are many sparse cases, and a
+ *		compare chain otherwise.
+ */
+
+void Switch::generate()
+{
+	TIME("generate Switch");
+
+	//Create new Labels
+	Label exitSwitch;
+	string otherwise;
+	vector<Case *> cases;
+	stringstream ss;
+
+	//Label every case, and find the default
+	ss << exitSwitch;
+	otherwise = ss.str();
+
+	for(unsigned i = 0; i < _cases.size(); i ++)
+	{
+		Label label;
+
+		ss.str("");
+		ss << label;
+		_cases[i]->_label = ss.str();
+
+		if(_cases[i]->isDefault())
+			otherwise = _cases[i]->_label;
+		else
+			cases.push_back(_cases[i]);
 	}
+
+	sort(cases.begin(), cases.end(), lowerCase);
+
+	//Do other generations
+	_expr -> generate();
+
+	//Load
+	context->out << "\tmovl\t" << _expr << ", %eax" << endl;
+
+	//Dispatch
+	if(cases.size() > MAX_CHAIN_CASES && cases.back()->value() - cases.front()->value() < (long) cases.size() * MAX_TABLE_SPREAD)
+		generateJumpTable(cases, otherwise);
+	else
+		generateDecisionTree(cases, 0, cases.size(), otherwise);
+
+	//Generate _stmt, with break leaving the switch
+	context->breakLabels.push_back(exitSwitch);
+	generateLine(_stmt);
+	_stmt -> generate();
+	context->breakLabels.pop_back();
+
+	//Print out exit label
+	context->out << exitSwitch << ":" << endl;
+}
+
+/*
+ * Function: Case::generate
+ *
+ * Description: Generate a "case" or "default" label, which was chosen
+ *		by the enclosing switch.
+ */
+
+void Case::generate()
+{
+	TIME("generate Case");
+
+	context->out << _label << ":" << endl;
+}
+
+/*
+ * Function: Break::generate
+ *
+ * Description: Generate "break" ASM code, which jumps to the exit of
+ *		the innermost loop or switch.
+ */
+
+void Break::generate()
+{
+	TIME("generate Break");
+
+	context->out << "\tjmp\t" << context->breakLabels.back() << endl;
 }
 
 /*
@@ -918,6 +2765,7 @@ void If::generate()
  */
 
 void LogicalOr::generate(){
+	TIME("generate LogicalOr");
 
 	//Generate Temp Variable Offset
 	assignTempOffset(this);
@@ -929,20 +2777,20 @@ void LogicalOr::generate(){
 	_left -> generate();
 	
 	//Comparison Operation
-	cout << "\tcmpl\t$0, " << _left << endl;
-	cout << "\tjne\t" << jumpLabel << endl;
+	compareToZero(_left);
+	context->out << "\tjne\t" << jumpLabel << endl;
 
 	//Do other generation
 	_right -> generate();
 
 	//Comparison Operation
-	cout << "\tcmpl\t$0, " << _right << endl;
+	compareToZero(_right);
 
 	//After Compare statement	
-	cout << jumpLabel << ":" << endl;
-	cout << "\tsetne\t%al" << endl;
-	cout << "\tmovzbl\t%al, %eax" << endl;
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << jumpLabel << ":" << endl;
+	context->out << "\tsetne\t%al" << endl;
+	context->out << "\tmovzbl\t%al, %eax" << endl;
+	context->out << "\tmovl\t%eax, " << this << endl;
 
 }
 
@@ -953,6 +2801,7 @@ void LogicalOr::generate(){
  */
 
 void LogicalAnd::generate(){
+	TIME("generate LogicalAnd");
 
 	//Generate Temp Variable Offset
 	assignTempOffset(this);
@@ -964,43 +2813,62 @@ void LogicalAnd::generate(){
 	_left -> generate();
 	
 	//Comparison Operation
-	cout << "\tcmpl\t$0, " << _left << endl;
-	cout << "\tje\t" << jumpLabel << endl;
+	compareToZero(_left);
+	context->out << "\tje\t" << jumpLabel << endl;
 
 	//Do other generation
 	_right -> generate();
 
 	//Comparison Operation
-	cout << "\tcmpl\t$0, " << _right << endl;
+	compareToZero(_right);
 
 	//After Compare statement	
-	cout << jumpLabel << ":" << endl;
-	cout << "\tsetne\t%al" << endl;
-	cout << "\tmovzbl\t%al, %eax" << endl;
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << jumpLabel << ":" << endl;
+	context->out << "\tsetne\t%al" << endl;
+	context->out << "\tmovzbl\t%al, %eax" << endl;
+	context->out << "\tmovl\t%eax, " << this << endl;
 
 }
 /*
  * Function: String::generate
  *
- * Description: Generate "string" operand ASM code
+ * Description: Generate "string" operand ASM code.  The literal itself
+ *		goes into the translation unit's pool, so identical strings
+ *		share a single label and nothing is written to the function
+ *		body.
  */
 
 void String::generate(){
+	TIME("generate String");
 
-	stringstream ss;
+	string contents = decodeString(value());
 
-	//Generate Label
-	Label stringLabel;
+	//Find or create this function's label for the string
+	if(context->strings.count(contents) == 0)
+	{
+		Label label;
 
-	//Cout String
-	cout << "\t.data\t" << endl;
-	cout << stringLabel << ":\t.asciz " << value() << endl;
-	cout << "\t.text\t" << endl;
+		context->strings[contents] = label.name;
+		lock_guard<mutex> lock(compiler->stringsLock);
+		compiler->strings[contents].insert(label.name);
+	}
 
 	//Store stringLabel for use into _operand
-	ss << stringLabel;
-	_operand = ss.str();
+	_operand = global(context->strings[contents]);
+}
+
+/*
+ * Function: Reuse::generate
+ *
+ * Description: The value was already computed by an earlier expression,
+ *		so we simply take its operand
+ */
+
+void Reuse::generate()
+{
+	TIME("generate Reuse");
+
+	_operand = _expr -> _operand;
 }
 
 /*
@@ -1011,6 +2879,8 @@ void String::generate(){
 
 void Dereference::generate()
 {
+	TIME("generate Dereference");
+
 	//Do other generations
 	_expr -> generate();
 	
@@ -1018,17 +2888,17 @@ void Dereference::generate()
 	assignTempOffset(this);
 
 	//Load
-	cout << "\tmovl\t" << _expr << ", %eax" << endl;
+	load(_expr, "ax", SIZEOF_PTR);
 
 	//Start Op
 	if(_type.size() == 1)
-		cout << "\tmovsbl\t (%eax), %eax" << endl;
+		context->out << "\tmovsbl\t (" << reg("ax", SIZEOF_PTR) << "), %eax" << endl;
 	else
-		cout << "\tmovl\t (%eax), %eax" << endl;
+		context->out << "\t" << op("mov", _type.size()) << "\t (" << reg("ax", SIZEOF_PTR) << "), " << reg("ax", _type.size()) << endl;
 	//End Op
 
 	//Store
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << "\t" << op("mov", _type.size()) << "\t" << reg("ax", _type.size()) << ", " << this << endl;
 }
 
 /*
@@ -1039,6 +2909,8 @@ void Dereference::generate()
 
 void Dereference::generate(bool &indirect)
 {
+	TIME("generate Dereference");
+
 	//Set indirect to True
 	indirect = true;	
 
@@ -1057,6 +2929,8 @@ void Dereference::generate(bool &indirect)
 
 void Address::generate()
 {
+	TIME("generate Address");
+
 	//Indirect?
 	bool indirect;
 
@@ -1075,10 +2949,10 @@ void Address::generate()
 		assignTempOffset(this);
 
 		//Load and Op
-		cout << "\tleal\t" << _expr << ", %eax" << endl;	
+		context->out << "\t" << op("lea", SIZEOF_PTR) << "\t" << _expr << ", " << reg("ax", SIZEOF_PTR) << endl;	
 			
 		//Store
-		cout << "\tmovl\t%eax, " << this << endl;
+		context->out << "\t" << op("mov", SIZEOF_PTR) << "\t" << reg("ax", SIZEOF_PTR) << ", " << this << endl;
 	}
 }
 
@@ -1090,6 +2964,8 @@ void Address::generate()
 
 void Field::generate()
 {
+	TIME("generate Field");
+
 	//Declare
 	bool indirect = false;
 
@@ -1097,16 +2973,16 @@ void Field::generate()
 	generate(indirect);
 
 	//Load
-	cout << "\tmovl\t" << this << ", %eax" << endl;
-	if(_type.size() == 4)
+	context->out << "\t" << op("mov", SIZEOF_PTR) << "\t" << this << ", " << reg("ax", SIZEOF_PTR) << endl;
+	if(_type.size() == 4 || _type.size() == 8)
 	{
-		//Offset for Int
-		cout << "\tmovl\t(%eax), %eax" << endl;
+		//Offset for Int or Pointer
+		context->out << "\t" << op("mov", _type.size()) << "\t(" << reg("ax", SIZEOF_PTR) << "), " << reg("ax", _type.size()) << endl;
 	}
 	else if(_type.size() == 1)
 	{
 		//Offset for Char
-		cout << "\tmovsbl\t(%eax), %eax" << endl;
+		context->out << "\tmovsbl\t(" << reg("ax", SIZEOF_PTR) << "), %eax" << endl;
 	}
 	else
 	{
@@ -1118,7 +2994,7 @@ void Field::generate()
 	assignTempOffset(this);
 
 	//Store
-	cout << "\tmovl\t%eax, " << this << endl;
+	context->out << "\t" << op("mov", _type.size()) << "\t" << reg("ax", _type.size()) << ", " << this << endl;
 }
 
 /*
@@ -1130,27 +3006,29 @@ void Field::generate()
 
 void Field::generate(bool &indirect)
 {
+	TIME("generate Field");
+
 	//Do other generations
 	_expr -> generate(indirect);
 	
 	//put struct reference into %eax
 	if(indirect)
 	{
-		cout << "\tmovl\t" << _expr << ", %eax" << endl;
+		context->out << "\t" << op("mov", SIZEOF_PTR) << "\t" << _expr << ", " << reg("ax", SIZEOF_PTR) << endl;
 	}
 	else
 	{
-		cout << "\tleal\t" << _expr << ", %eax" << endl;
+		context->out << "\t" << op("lea", SIZEOF_PTR) << "\t" << _expr << ", " << reg("ax", SIZEOF_PTR) << endl;
 	}
 	
 	//Generate Temp Variable Offset
 	assignTempOffset(this);
 
 	//Add offset of _id to %eax
-	cout << "\taddl\t$" << _id -> symbol() -> _offset << ", %eax" << endl;
+	context->out << "\t" << op("add", SIZEOF_PTR) << "\t$" << _id -> symbol() -> _offset << ", " << reg("ax", SIZEOF_PTR) << endl;
 
 	//Move %eax -> this
-	cout <<"\tmovl\t%eax, " << this << endl;
+	context->out <<"\t" << op("mov", SIZEOF_PTR) << "\t" << reg("ax", SIZEOF_PTR) << ", " << this << endl;
 
 	//Set indirect to true
 	indirect = true;
@@ -0,0 +1,331 @@
+/*
+ * File:	incremental.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for reusing the code of functions that have not
+ *		changed since they were last compiled.  The code of a
+ *		function is kept in the cache (see cache.cpp) under a key
+ *		made of the tokens of its definition and the signatures of
+ *		everything outside it that it depends on: the types of the
+ *		globals it uses, the types of the functions it calls, and
+ *		the layouts of the structures it names or reaches.  A
+ *		change to any of them, such as a field added to a structure
+ *		in a header, is a different key, so a stale function is
+ *		never reused.
+ *
+ *		The parser records the tokens of each top-level declaration
+ *		as they are matched, and makes the key of a function as
+ *		soon as its definition is complete, before the optimizer or
+ *		a code generator thread can change its tree.  The key is
+ *		then looked up when the function is generated.  Along with
+ *		its code, an entry keeps the labels the function gave its
+ *		string literals, since the literals themselves are laid out
+ *		with the rest of the program.
+ */
+
+# include <set>
+# include <vector>
+# include <cstdlib>
+# include <sstream>
+# include "cache.h"
+# include "tokens.h"
+# include "checker.h"
+# include "compiler.h"
+# include "incremental.h"
+
+using namespace std;
+
+
+/*
+ * Function:	recordToken
+ *
+ * Description:	Add a matched token to the tokens of the current top-level
+ *		declaration.  The parser clears them at the start of each.
+ */
+
+void recordToken(int token, const string &lexeme)
+{
+    compiler->span += to_string(token) + " " + lexeme + "\n";
+}
+
+
+/*
+ * Function:	signature
+ *
+ * Description:	Write a type, with the types of its parameters if it is a
+ *		function type whose parameters are known.
+ */
+
+static void signature(ostream &out, const Type &type)
+{
+    out << type;
+
+    if (type.isFunction() && type.parameters() != nullptr) {
+	out << " (";
+
+	for (unsigned i = 0; i < type.parameters()->size(); i ++)
+	    out << (i > 0 ? ", " : "") << (*type.parameters())[i];
+
+	out << ")";
+    }
+}
+
+
+/*
+ * Function:	layout
+ *
+ * Description:	Write the layout of a structure: its size and the name,
+ *		type, and offset of each field, followed by the layouts of
+ *		any structures within it.
+ */
+
+static void layout(ostream &out, const string &name, set<string> &done)
+{
+    Symbols fields;
+    vector<string> nested;
+
+
+    if (!done.insert(name).second)
+	return;
+
+    if (compiler->fields.count(name) == 0) {
+	out << name << " incomplete" << endl;
+	return;
+    }
+
+    fields = getFields(name);
+    out << name << " " << Type(name).size() << " {";
+
+    for (unsigned i = 0; i < fields.size(); i ++) {
+	const Type &type = fields[i]->type();
+
+	out << " " << fields[i]->name() << " " << type << " @" << fields[i]->_offset << ";";
+
+	if (type.isStruct() && type.indirection() == 0)
+	    nested.push_back(type.specifier());
+    }
+
+    out << " }" << endl;
+
+    for (unsigned i = 0; i < nested.size(); i ++)
+	layout(out, nested[i], done);
+}
+
+
+/*
+ * Function:	findDependences
+ *
+ * Description:	Collect the globals used, the functions called, and the
+ *		structures reached by the expressions in the tree.
+ */
+
+static void findDependences(Statement *stmt, set<const Symbol *> &symbols, set<string> &structs)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Expression *expr;
+    Identifier *id;
+    Call *call;
+
+
+    if ((call = dynamic_cast<Call *>(stmt)) != nullptr)
+	symbols.insert(call->symbol());
+
+    else if ((id = dynamic_cast<Identifier *>(stmt)) != nullptr)
+	if (compiler->outermost->find(id->symbol()->name()) == id->symbol())
+	    symbols.insert(id->symbol());
+
+    if ((expr = dynamic_cast<Expression *>(stmt)) != nullptr)
+	if (expr->type().isStruct())
+	    structs.insert(expr->type().specifier());
+
+    stmt->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	findDependences(*stmts[i], symbols, structs);
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	findDependences(*exprs[i], symbols, structs);
+}
+
+
+/*
+ * Function:	findLines
+ *
+ * Description:	Write the lines of the statements in the tree, which are
+ *		in the code with -g.  Only the parser adds lines, and it is
+ *		the thread making the key, so they need no lock here.
+ */
+
+static void findLines(Statement *stmt, ostream &key)
+{
+    map<const Statement *, int>::const_iterator it;
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    if ((it = compiler->lines.find(stmt)) != compiler->lines.end())
+	key << " " << it->second;
+
+    stmt->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	findLines(*stmts[i], key);
+}
+
+
+/*
+ * Function:	keyFunction
+ *
+ * Description:	Make the key of a function whose definition was just
+ *		parsed.  Every structure named by a token of the definition
+ *		is included, which covers the parameters, the locals, casts,
+ *		and sizeof, along with every structure that is the type of
+ *		an expression.  The block counts of the function are
+ *		included if there is a profile, and the lines of its
+ *		statements with -g.
+ */
+
+void keyFunction(const Function *function)
+{
+    set<const Symbol *> symbols;
+    set<const Symbol *>::iterator sym;
+    set<string> structs, done;
+    set<string>::iterator it;
+    Profile::const_iterator counts;
+    istringstream tokens(compiler->span);
+    stringstream key;
+    string line;
+    int last = 0;
+
+
+    key << "function" << endl << compiler->span;
+
+    while (getline(tokens, line)) {
+	int token = atoi(line.c_str());
+
+	if (last == STRUCT && token == ID)
+	    structs.insert(line.substr(line.find(' ') + 1));
+
+	last = token;
+    }
+
+    findDependences(function->body(), symbols, structs);
+
+    for (sym = symbols.begin(); sym != symbols.end(); sym ++) {
+	key << "uses " << (*sym)->name() << ": ";
+	signature(key, (*sym)->type());
+	key << endl;
+
+	if ((*sym)->type().isStruct())
+	    structs.insert((*sym)->type().specifier());
+    }
+
+    for (it = structs.begin(); it != structs.end(); it ++)
+	layout(key, *it, done);
+
+    if (compiler->options.debug) {
+	key << "lines";
+	findLines(function->body(), key);
+	key << endl;
+    }
+
+    counts = compiler->profile.find(function->symbol()->name());
+
+    if (counts != compiler->profile.end()) {
+	key << "profile";
+
+	for (unsigned i = 0; i < counts->second.size(); i ++)
+	    key << " " << counts->second[i];
+
+	key << endl;
+    }
+
+    lock_guard<mutex> lock(compiler->keysLock);
+    compiler->keys[function] = compiler->cache->key(compiler->options, key.str());
+}
+
+
+/*
+ * Function:	findFunction
+ *
+ * Description:	Look up the code of a function.  On a hit, the labels of
+ *		its string literals are entered in the string pool.  On a
+ *		miss, KEY is left for the code to be inserted under once
+ *		generated, or is empty if the function has no key.
+ */
+
+bool findFunction(const Function *function, string &key, string &assembly)
+{
+    string entry, label, contents;
+    unsigned count, length;
+
+
+    {
+	lock_guard<mutex> lock(compiler->keysLock);
+
+	if (compiler->keys.count(function) == 0) {
+	    key.clear();
+	    return false;
+	}
+
+	key = compiler->keys[function];
+    }
+
+    if (!compiler->cache->find(key, entry, true))
+	return false;
+
+    istringstream in(entry);
+    vector<pair<string, string>> strings;
+
+    if (!(in >> count) || in.get() != '\n')
+	return false;
+
+    for (unsigned i = 0; i < count; i ++) {
+	if (!getline(in, label) || !(in >> length) || in.get() != '\n')
+	    return false;
+
+	if (length > entry.size())
+	    return false;
+
+	contents.resize(length);
+
+	if (!in.read(&contents[0], length) || in.get() != '\n')
+	    return false;
+
+	strings.push_back(make_pair(label, contents));
+    }
+
+    lock_guard<mutex> lock(compiler->stringsLock);
+
+    for (unsigned i = 0; i < strings.size(); i ++)
+	compiler->strings[strings[i].second].insert(strings[i].first);
+
+    assembly = entry.substr(in.tellg());
+    return true;
+}
+
+
+/*
+ * Function:	insertFunction
+ *
+ * Description:	Keep the code of a function and the labels of its strings,
+ *		which map the contents of each literal to its label.  The
+ *		contents are decoded and may hold newlines, so each is
+ *		preceded by its length.
+ */
+
+void insertFunction(const string &key, const string &assembly, const map<string, string> &strings)
+{
+    map<string, string>::const_iterator it;
+    stringstream entry;
+
+
+    entry << strings.size() << endl;
+
+    for (it = strings.begin(); it != strings.end(); it ++)
+	entry << it->second << endl << it->first.size() << endl << it->first << endl;
+
+    entry << assembly;
+    compiler->cache->insert(key, entry.str());
+}
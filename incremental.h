@@ -0,0 +1,22 @@
+/*
+ * File:	incremental.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		reusing the code of functions that have not changed since
+ *		they were last compiled.
+ */
+
+# ifndef INCREMENTAL_H
+# define INCREMENTAL_H
+# include <map>
+# include <string>
+# include "Tree.h"
+
+void recordToken(int token, const std::string &lexeme);
+void keyFunction(const Function *function);
+
+bool findFunction(const Function *function, std::string &key, std::string &assembly);
+void insertFunction(const std::string &key, const std::string &assembly,
+	const std::map<std::string, std::string> &strings);
+
+# endif /* INCREMENTAL_H */
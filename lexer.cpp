@@ -3,6 +3,8 @@
  *
  * Description:	This file contains the public and private function and
  *		variable definitions for the lexical analyzer for Simple C.
+ *		The input, line number, and error count belong to the
+ *		current compiler context (see compiler.h).
  */
 
 # include <cstdio>
@@ -13,9 +15,10 @@
 # include <iostream>
 # include "lexer.h"
 # include "tokens.h"
+# include "compiler.h"
+# include "timing.h"
 
 using namespace std;
-int numerrors, lineno = 1;
 
 
 /* Yes, we could have used a map, but we'd probably initialize it with an
@@ -65,11 +68,13 @@ static struct {
 /*
  * Function:	report
  *
- * Description:	Report an error to the standard error prefixed with the
- *		line number.  We'll be using this a lot later with an
+ * Description:	Report an error to the error stream of the compilation
+ *		prefixed with the line number.  We'll be using this a lot later with an
  *		optional string argument, but C++'s stupid streams don't do
  *		positional arguments, so we actually resort to snprintf.
  *		You just can't beat C for doing things down and dirty.
+ *		With -fpipeline, the code generator thread writes its
+ *		reports to the same stream, so we hold its lock.
  */
 
 void report(const string &str, const string &arg)
@@ -77,30 +82,34 @@ void report(const string &str, const string &arg)
     char buf[1000];
 
     snprintf(buf, sizeof(buf), str.c_str(), arg.c_str());
-    cerr << "line " << lineno << ": " << buf << endl;
-    numerrors ++;
+    lock_guard<mutex> lock(compiler->errLock);
+    *compiler->err << "line " << compiler->lineno << ": " << buf << endl;
+    compiler->numerrors ++;
 }
 
 
 /*
  * Function:	lexan
  *
- * Description:	Read and tokenize the standard input stream.  The lexeme is
- *		stored in a buffer.
+ * Description:	Read and tokenize the input stream of the compilation.  The
+ *		lexeme is stored in a buffer.
  */
 
 int lexan(string &lexbuf)
 {
+    TIME("lexan");
+
     int p;
     unsigned i;
-    static int c = cin.get();
+    istream &in = *compiler->in;
+    int &c = compiler->c;
 
 
     /* The invariant here is that the next character has already been read
        and is ready to be classified.  In this way, we eliminate having to
        push back characters onto the stream, merely to read them again. */
 
-    while (!cin.eof()) {
+    while (!in.eof()) {
 	lexbuf.clear();
 
 
@@ -108,9 +117,9 @@ int lexan(string &lexbuf)
 
 	while (isspace(c)) {
 	    if (c == '\n')
-		lineno ++;
+		compiler->lineno ++;
 
-	    c = cin.get();
+	    c = in.get();
 	}
 
 
@@ -119,7 +128,7 @@ int lexan(string &lexbuf)
 	if (isalpha(c) || c == '_') {
 	    do {
 		lexbuf += c;
-		c = cin.get();
+		c = in.get();
 	    } while (isalnum(c) || c == '_');
 
 	    for (i = 0; i < numKeywords; i ++)
@@ -134,7 +143,7 @@ int lexan(string &lexbuf)
 	} else if (isdigit(c)) {
 	    do {
 		lexbuf += c;
-		c = cin.get();
+		c = in.get();
 	    } while (isdigit(c));
 
 	    return NUM;
@@ -154,11 +163,11 @@ int lexan(string &lexbuf)
 	    /* Check for '||' */
 
 	    case '|':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '|') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return OR;
 		}
 
@@ -168,11 +177,11 @@ int lexan(string &lexbuf)
 	    /* Check for '=' and '==' */
 
 	    case '=':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '=') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return EQL;
 		}
 
@@ -182,11 +191,11 @@ int lexan(string &lexbuf)
 	    /* Check for '&' and '&&' */
 
 	    case '&':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '&') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return AND;
 		}
 
@@ -196,11 +205,11 @@ int lexan(string &lexbuf)
 	    /* Check for '!' and '!=' */
 
 	    case '!':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '=') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return NEQ;
 		}
 
@@ -210,11 +219,11 @@ int lexan(string &lexbuf)
 	    /* Check for '<' and '<=' */
 
 	    case '<':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '=') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return LEQ;
 		}
 
@@ -224,11 +233,11 @@ int lexan(string &lexbuf)
 	    /* Check for '>' and '>=' */
 
 	    case '>':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '=') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return GEQ;
 		}
 
@@ -238,16 +247,16 @@ int lexan(string &lexbuf)
 	    /* Check for '-', '--', and '->' */
 
 	    case '-':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '-') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return DEC;
 
 		} else if (c == '>') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return ARROW;
 		}
 
@@ -257,11 +266,11 @@ int lexan(string &lexbuf)
 	    /* Check for '+' and '++' */
 
 	    case '+':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '+') {
 		    lexbuf += c;
-		    c = cin.get();
+		    c = in.get();
 		    return INC;
 		}
 
@@ -273,28 +282,28 @@ int lexan(string &lexbuf)
 	    case '*': case '%': case ':': case ';':
 	    case '(': case ')': case '[': case ']':
 	    case '{': case '}': case '.': case ',':
-		c = cin.get();
+		c = in.get();
 		return lexbuf[0];
 
 
 	    /* Check for '/' or a comment */
 
 	    case '/':
-		c = cin.get();
+		c = in.get();
 
 		if (c == '*') {
 		    do {
-			while (c != '*' && !cin.eof()) {
+			while (c != '*' && !in.eof()) {
 			    if (c == '\n')
-				lineno ++;
+				compiler->lineno ++;
 
-			    c = cin.get();
+			    c = in.get();
 			}
 
-			c = cin.get();
-		    } while (c != '/' && !cin.eof());
+			c = in.get();
+		    } while (c != '/' && !in.eof());
 
-		    c = cin.get();
+		    c = in.get();
 		    break;
 
 		} else
@@ -306,14 +315,14 @@ int lexan(string &lexbuf)
 	    case '"':
 		do {
 		    p = c;
-		    c = cin.get();
+		    c = in.get();
 		    lexbuf += c;
-		} while ((c != '"' || p == '\\') && c != '\n' && !cin.eof());
+		} while ((c != '"' || p == '\\') && c != '\n' && !in.eof());
 
-		if (c == '\n' || cin.eof())
+		if (c == '\n' || in.eof())
 		    report("malformed string literal");
 
-		c = cin.get();
+		c = in.get();
 		return STRING;
 
 
@@ -322,14 +331,14 @@ int lexan(string &lexbuf)
 	    case '\'':
 		do {
 		    p = c;
-		    c = cin.get();
+		    c = in.get();
 		    lexbuf += c;
-		} while ((c != '\'' || p == '\\') && c != '\n' && !cin.eof());
+		} while ((c != '\'' || p == '\\') && c != '\n' && !in.eof());
 
-		if (c == '\n' || cin.eof() || charval(lexbuf) == -1)
+		if (c == '\n' || in.eof() || charval(lexbuf) == -1)
 		    report("malformed character literal");
 
-		c = cin.get();
+		c = in.get();
 		return CHARACTER;
 
 
@@ -342,7 +351,7 @@ int lexan(string &lexbuf)
 	    /* Everything else is illegal */
 
 	    default:
-		c = cin.get();
+		c = in.get();
 		return ERROR;
 	    }
 	}
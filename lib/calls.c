@@ -0,0 +1,278 @@
+/*
+ * File:	calls.c
+ *
+ * Description:	This file contains the reference hooks for programs
+ *		compiled with -finstrument-functions, which call
+ *		__cyg_profile_func_enter and __cyg_profile_func_exit with
+ *		the address of each function and the address it was called
+ *		from.  The hooks count the calls of each function and of
+ *		each caller and callee pair, and time each function from
+ *		entry to exit, including the functions it calls.  The time
+ *		of a recursive function is only taken for its outermost
+ *		call, so that it is not counted twice.
+ *
+ *		When the program exits, the functions are written to the
+ *		file named by SCC_CALLS, or to scc.calls, slowest first,
+ *		followed by the calls between them:
+ *
+ *			function calls seconds
+ *			caller -> callee calls
+ *
+ *		Functions are named from the records that the compiler
+ *		leaves in the scc_functions section.  The hooks keep one
+ *		stack of calls, so the program must be single-threaded.
+ *
+ *		This file is compiled by the host C compiler, for the
+ *		same target as the compiler's output.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <time.h>
+
+# define MAX_FUNCTIONS 4096
+# define MAX_EDGES 16384
+# define MAX_DEPTH 4096
+
+struct record {
+    void *address;
+    const char *name;
+};
+
+struct function {
+    void *address;
+    unsigned long long calls, nanoseconds;
+    unsigned active;
+};
+
+struct edge {
+    struct function *caller, *callee;
+    unsigned long long calls;
+};
+
+struct frame {
+    struct function *function;
+    unsigned long long start;
+};
+
+extern struct record __start_scc_functions[] __attribute__((weak));
+extern struct record __stop_scc_functions[] __attribute__((weak));
+
+static struct function functions[MAX_FUNCTIONS];
+static struct edge edges[MAX_EDGES];
+static struct frame stack[MAX_DEPTH];
+static unsigned depth;
+
+void __cyg_profile_func_enter(void *function, void *site);
+void __cyg_profile_func_exit(void *function, void *site);
+
+
+/*
+ * Function:	now
+ *
+ * Description:	Return the time in nanoseconds.
+ */
+
+static unsigned long long now(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/*
+ * Function:	lookup
+ *
+ * Description:	Return the entry of a function in the hash table, making
+ *		one if it is not there.  Null is returned if the table is
+ *		full.
+ */
+
+static struct function *lookup(void *address)
+{
+    unsigned i, n;
+
+
+    i = ((unsigned long) address >> 2) % MAX_FUNCTIONS;
+
+    for (n = 0; n < MAX_FUNCTIONS; n ++, i = (i + 1) % MAX_FUNCTIONS) {
+	if (functions[i].address == address)
+	    return &functions[i];
+
+	if (functions[i].address == NULL) {
+	    functions[i].address = address;
+	    return &functions[i];
+	}
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Function:	count
+ *
+ * Description:	Count a call from CALLER to CALLEE in the hash table of
+ *		edges, unless it is full.
+ */
+
+static void count(struct function *caller, struct function *callee)
+{
+    unsigned i, n;
+
+
+    i = ((unsigned long) caller / sizeof(*caller) * 31 + (unsigned long) callee / sizeof(*callee)) % MAX_EDGES;
+
+    for (n = 0; n < MAX_EDGES; n ++, i = (i + 1) % MAX_EDGES) {
+	if (edges[i].caller == caller && edges[i].callee == callee) {
+	    edges[i].calls ++;
+	    return;
+	}
+
+	if (edges[i].caller == NULL) {
+	    edges[i].caller = caller;
+	    edges[i].callee = callee;
+	    edges[i].calls = 1;
+	    return;
+	}
+    }
+}
+
+
+/*
+ * Function:	__cyg_profile_func_enter
+ *
+ * Description:	Count a call of a function and start timing it.
+ */
+
+void __cyg_profile_func_enter(void *address, void *site)
+{
+    struct function *function;
+
+
+    if ((function = lookup(address)) == NULL)
+	return;
+
+    function->calls ++;
+
+    if (depth > 0 && depth <= MAX_DEPTH && stack[depth - 1].function != NULL)
+	count(stack[depth - 1].function, function);
+
+    if (depth < MAX_DEPTH) {
+	stack[depth].function = function;
+	stack[depth].start = (function->active ++ == 0 ? now() : 0);
+    }
+
+    depth ++;
+}
+
+
+/*
+ * Function:	__cyg_profile_func_exit
+ *
+ * Description:	Stop timing a call of a function, charging it for the time
+ *		since entry if this is its outermost call.
+ */
+
+void __cyg_profile_func_exit(void *address, void *site)
+{
+    struct frame *frame;
+
+
+    if (depth == 0 || lookup(address) == NULL)
+	return;
+
+    if (-- depth < MAX_DEPTH) {
+	frame = &stack[depth];
+
+	if (-- frame->function->active == 0)
+	    frame->function->nanoseconds += now() - frame->start;
+    }
+}
+
+
+/*
+ * Function:	name
+ *
+ * Description:	Return the name of the function at an address.
+ */
+
+static const char *name(void *address)
+{
+    static char buffer[32];
+    const struct record *record;
+
+
+    for (record = __start_scc_functions; record < __stop_scc_functions; record ++)
+	if (record->address == address)
+	    return record->name;
+
+    sprintf(buffer, "%p", address);
+    return buffer;
+}
+
+
+/*
+ * Function:	slower
+ *
+ * Description:	Order functions from slowest to fastest.
+ */
+
+static int slower(const void *a, const void *b)
+{
+    const struct function *f = *(struct function *const *) a;
+    const struct function *g = *(struct function *const *) b;
+
+
+    if (f->nanoseconds != g->nanoseconds)
+	return f->nanoseconds < g->nanoseconds ? 1 : -1;
+
+    return f->calls < g->calls ? 1 : f->calls > g->calls ? -1 : 0;
+}
+
+
+/*
+ * Function:	writeCalls
+ *
+ * Description:	Write the functions, slowest first, and then the calls
+ *		between them.
+ */
+
+static void __attribute__((destructor)) writeCalls(void)
+{
+    static struct function *sorted[MAX_FUNCTIONS];
+    unsigned i, n = 0;
+    const char *path;
+    FILE *fp;
+
+
+    if ((path = getenv("SCC_CALLS")) == NULL)
+	path = "scc.calls";
+
+    if ((fp = fopen(path, "w")) == NULL) {
+	perror(path);
+	return;
+    }
+
+    for (i = 0; i < MAX_FUNCTIONS; i ++)
+	if (functions[i].calls > 0)
+	    sorted[n ++] = &functions[i];
+
+    qsort(sorted, n, sizeof(sorted[0]), slower);
+
+    for (i = 0; i < n; i ++) {
+	fprintf(fp, "%s %llu ", name(sorted[i]->address), sorted[i]->calls);
+	fprintf(fp, "%.6f\n", sorted[i]->nanoseconds / 1e9);
+    }
+
+    for (i = 0; i < MAX_EDGES; i ++)
+	if (edges[i].caller != NULL) {
+	    fprintf(fp, "%s -> ", name(edges[i].caller->address));
+	    fprintf(fp, "%s %llu\n", name(edges[i].callee->address), edges[i].calls);
+	}
+
+    fclose(fp);
+}
@@ -0,0 +1,66 @@
+/*
+ * File:	profile.c
+ *
+ * Description:	This file contains the runtime support for programs compiled
+ *		with -finstrument.  Each instrumented function leaves a
+ *		record of its block counters in the scc_profile section,
+ *		and the linker marks the bounds of the section for us.
+ *		When the program exits, the count of every block is
+ *		appended to the profile named by SCC_PROFILE, or to
+ *		scc.profile, one block to a line:
+ *
+ *			function block count
+ *
+ *		The profile is appended to so that several runs add up;
+ *		the compiler sums the counts of a block when it reads them.
+ *
+ *		This file is compiled by the host C compiler, for the
+ *		same target as the compiler's output.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+
+struct record {
+    const char *name;
+    unsigned blocks;
+    unsigned long long *counts;
+};
+
+extern struct record __start_scc_profile[] __attribute__((weak));
+extern struct record __stop_scc_profile[] __attribute__((weak));
+
+
+/*
+ * Function:	writeProfile
+ *
+ * Description:	Append the counts of all blocks to the profile.
+ */
+
+static void __attribute__((destructor)) writeProfile(void)
+{
+    const struct record *record;
+    const char *path;
+    unsigned block;
+    FILE *fp;
+
+
+    record = __start_scc_profile;
+
+    if (record == __stop_scc_profile)
+	return;
+
+    if ((path = getenv("SCC_PROFILE")) == NULL)
+	path = "scc.profile";
+
+    if ((fp = fopen(path, "a")) == NULL) {
+	perror(path);
+	return;
+    }
+
+    for (; record < __stop_scc_profile; record ++)
+	for (block = 0; block < record->blocks; block ++)
+	    fprintf(fp, "%s %u %llu\n", record->name, block, record->counts[block]);
+
+    fclose(fp);
+}
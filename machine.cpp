@@ -0,0 +1,53 @@
+/*
+ * File:	machine.cpp
+ *
+ * Description:	This file contains the public function definitions for
+ *		the target machines.  On i386, every argument is pushed on
+ *		the stack in a word of its own.  On x86-64, pointers take
+ *		eight bytes while an int stays at four, the first six
+ *		arguments are passed in registers and the rest on the
+ *		stack in eight bytes each, the stack is aligned to sixteen
+ *		bytes at each call, and globals are addressed relative to
+ *		the instruction pointer so that the code is position
+ *		independent.
+ */
+
+# include "machine.h"
+# include "compiler.h"
+
+using namespace std;
+
+static const Machine machines[] = {
+    {"i386", 1, 1, 4, 4, 4, 4, 4, 8, I386_STACK_ALIGNMENT, 0, false},
+    {"x86_64", 1, 1, 4, 4, 8, 8, 8, 16, 16, 6, true},
+};
+
+
+/*
+ * Function:	findMachine
+ *
+ * Description:	Return the machine with the given name, or null if there
+ *		is no such machine.
+ */
+
+const Machine *findMachine(const string &name)
+{
+    for (unsigned i = 0; i < sizeof(machines) / sizeof(machines[0]); i ++)
+	if (name == machines[i].name)
+	    return &machines[i];
+
+    return nullptr;
+}
+
+
+/*
+ * Function:	machine
+ *
+ * Description:	Return the target machine of the compilation this thread
+ *		is working on.
+ */
+
+const Machine &machine()
+{
+    return *compiler->target;
+}
@@ -2,34 +2,65 @@
  * File:	machine.h
  *
  * Description:	This file contains the values of various parameters for the
- *		target machine architecture.
+ *		target machine architecture.  The sizes and alignments of
+ *		the types and the calling convention are those of the
+ *		machine chosen for the compilation, either i386 (-m32) or
+ *		x86-64 System V (-m64), and are looked up at run time.  The
+ *		names and directives of the assembly depend on the platform
+ *		the compiler was built for.
  */
 
-# define SIZEOF_CHAR 1
-# define ALIGNOF_CHAR 1
+# ifndef MACHINE_H
+# define MACHINE_H
+# include <string>
 
-# define SIZEOF_INT 4
-# define ALIGNOF_INT 4
+struct Machine {
+    const char *name;
+    unsigned sizeofChar, alignofChar;
+    unsigned sizeofInt, alignofInt;
+    unsigned sizeofPtr, alignofPtr;
+    unsigned sizeofArg, paramOffset, stackAlignment;
+    unsigned registerArgs;
+    bool positionIndependent;
+};
 
-# define SIZEOF_PTR 4
-# define ALIGNOF_PTR 4
+const Machine *findMachine(const std::string &name);
+const Machine &machine();
 
-# define SIZEOF_ARG 4
-# define PARAM_OFFSET 8
+# define SIZEOF_CHAR (machine().sizeofChar)
+# define ALIGNOF_CHAR (machine().alignofChar)
+
+# define SIZEOF_INT (machine().sizeofInt)
+# define ALIGNOF_INT (machine().alignofInt)
+
+# define SIZEOF_PTR (machine().sizeofPtr)
+# define ALIGNOF_PTR (machine().alignofPtr)
+
+# define SIZEOF_ARG (machine().sizeofArg)
+# define PARAM_OFFSET (machine().paramOffset)
+
+# define STACK_ALIGNMENT (machine().stackAlignment)
+# define REGISTER_ARGS (machine().registerArgs)
 
 # if defined (__linux__) && (defined(__i386__) || defined(__x86_64__))
 
-# define STACK_ALIGNMENT 4
+# define I386_STACK_ALIGNMENT 4
 # define global_prefix ""
 # define label_prefix ".L"
+# define plt_suffix "@PLT"
+# define symbol_types 1
 
 # elif defined (__APPLE__) && (defined(__i386__) || defined(__x86_64__))
 
-# define STACK_ALIGNMENT 16
+# define I386_STACK_ALIGNMENT 16
 # define global_prefix "_"
 # define label_prefix "L"
+# define plt_suffix ""
+# define symbol_types 0
 
 # else
 
 # error Unsupport architecture
 # endif
+
+# endif /* MACHINE_H */
@@ -0,0 +1,178 @@
+/*
+ * File:	memory.cpp
+ *
+ * Description:	This file contains the member and public function
+ *		definitions for accounting for the storage of a
+ *		compilation.  The objects and bytes of each kind of storage
+ *		are counted for the whole compilation, along with the bytes
+ *		still in use and the most ever in use at once.  Functions
+ *		may be generated on several threads, so the counts are
+ *		atomic.
+ *
+ *		The parser also counts the storage of each top-level
+ *		declaration as it is parsed and checked, and keeps the
+ *		counts of each function definition.  Only the parsing
+ *		thread watches a declaration, so that storage made by code
+ *		generator threads at the same time is not charged to it.
+ */
+
+# include <iomanip>
+# include "memory.h"
+# include "compiler.h"
+
+using namespace std;
+
+static thread_local Usage *usage;
+
+static const char *names[] = {
+    "nodes", "symbols", "scopes", "parameters", "strings"
+};
+
+
+/*
+ * Function:	Usage::Usage (constructor)
+ *
+ * Description:	Initialize the usage of a declaration to nothing.
+ */
+
+Usage::Usage()
+{
+    for (unsigned i = 0; i < STORAGES; i ++)
+	objects[i] = bytes[i] = 0;
+}
+
+
+/*
+ * Function:	Memory::Memory (constructor)
+ *
+ * Description:	Initialize the storage of a compilation to nothing.
+ */
+
+Memory::Memory()
+    : total(0), peak(0)
+{
+    for (unsigned i = 0; i < STORAGES; i ++)
+	objects[i] = bytes[i] = live[i] = 0;
+}
+
+
+/*
+ * Function:	allocated
+ *
+ * Description:	Count storage as allocated if a memory report is wanted.
+ */
+
+void allocated(Storage storage, unsigned long bytes, unsigned long objects)
+{
+    Memory &memory = compiler->memory;
+    unsigned long total, peak;
+
+
+    if (!compiler->options.memoryReport)
+	return;
+
+    memory.objects[storage] += objects;
+    memory.bytes[storage] += bytes;
+    memory.live[storage] += bytes;
+
+    total = memory.total += bytes;
+    peak = memory.peak;
+
+    while (total > peak && !memory.peak.compare_exchange_weak(peak, total))
+	continue;
+
+    if (usage != nullptr) {
+	usage->objects[storage] += objects;
+	usage->bytes[storage] += bytes;
+    }
+}
+
+
+/*
+ * Function:	released
+ *
+ * Description:	Count storage as freed if a memory report is wanted.  The
+ *		storage of a declaration only ever grows.
+ */
+
+void released(Storage storage, unsigned long bytes)
+{
+    Memory &memory = compiler->memory;
+
+
+    if (!compiler->options.memoryReport)
+	return;
+
+    memory.live[storage] -= bytes;
+    memory.total -= bytes;
+}
+
+
+/*
+ * Function:	watchUsage
+ *
+ * Description:	Count the storage allocated by this thread against USAGE as
+ *		well, or against nothing more if it is null.
+ */
+
+void watchUsage(Usage *usage)
+{
+    ::usage = usage;
+}
+
+
+/*
+ * Function:	reportMemory
+ *
+ * Description:	Write the storage of each kind allocated for a compilation,
+ *		the storage still in use, and the most in use at once,
+ *		followed by the bytes of each kind allocated for each
+ *		function.
+ */
+
+void reportMemory(ostream &out, const Memory &memory)
+{
+    unsigned long objects = 0, bytes = 0, live = 0;
+
+
+    out << left << setw(16) << "storage" << right << setw(12) << "objects";
+    out << setw(12) << "bytes" << setw(12) << "live" << endl;
+
+    for (unsigned i = 0; i < STORAGES; i ++) {
+	out << left << setw(16) << names[i] << right;
+	out << setw(12) << memory.objects[i] << setw(12) << memory.bytes[i];
+	out << setw(12) << memory.live[i] << endl;
+
+	objects += memory.objects[i];
+	bytes += memory.bytes[i];
+	live += memory.live[i];
+    }
+
+    out << left << setw(16) << "total" << right << setw(12) << objects;
+    out << setw(12) << bytes << setw(12) << live << endl;
+    out << left << setw(16) << "peak" << right << setw(36) << memory.peak << endl;
+
+    if (memory.functions.empty())
+	return;
+
+    out << endl << left << setw(16) << "function" << right;
+
+    for (unsigned i = 0; i < STORAGES; i ++)
+	out << setw(12) << names[i];
+
+    out << setw(12) << "total" << endl;
+
+    for (unsigned i = 0; i < memory.functions.size(); i ++) {
+	const Usage &usage = memory.functions[i].second;
+
+	out << left << setw(16) << memory.functions[i].first << right;
+	bytes = 0;
+
+	for (unsigned j = 0; j < STORAGES; j ++) {
+	    out << setw(12) << usage.bytes[j];
+	    bytes += usage.bytes[j];
+	}
+
+	out << setw(12) << bytes << endl;
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * File:	memory.h
+ *
+ * Description:	This file contains the class definitions and public
+ *		function declarations for accounting for the storage of a
+ *		compilation.  The trees, symbols, scopes, and parameter
+ *		lists of the compiler are all made with create() and freed
+ *		with destroy(), which count the objects and bytes of each
+ *		kind of storage when a memory report is asked for.
+ */
+
+# ifndef MEMORY_H
+# define MEMORY_H
+# include <atomic>
+# include <string>
+# include <vector>
+# include <utility>
+# include <ostream>
+# include "Tree.h"
+# include "Type.h"
+# include "Scope.h"
+# include "Symbol.h"
+
+enum Storage { NODES, SYMBOLS, SCOPES, PARAMETERS, STRINGS, STORAGES };
+
+struct Usage {
+    unsigned long objects[STORAGES], bytes[STORAGES];
+    Usage();
+};
+
+struct Memory {
+    std::atomic<unsigned long> objects[STORAGES], bytes[STORAGES];
+    std::atomic<unsigned long> live[STORAGES], total, peak;
+
+    Usage declaration;
+    std::vector<std::pair<std::string, Usage> > functions;
+
+    Memory();
+};
+
+void allocated(Storage storage, unsigned long bytes, unsigned long objects = 1);
+void released(Storage storage, unsigned long bytes);
+
+void watchUsage(Usage *usage);
+void reportMemory(std::ostream &out, const Memory &memory);
+
+
+/* The kind of storage of an object, and the bytes it takes */
+
+inline Storage storage(const Statement *) { return NODES; }
+inline Storage storage(const Function *) { return NODES; }
+inline Storage storage(const Symbol *) { return SYMBOLS; }
+inline Storage storage(const Scope *) { return SCOPES; }
+inline Storage storage(const Parameters *) { return PARAMETERS; }
+
+template<class T>
+inline unsigned long footprint(const T *) { return sizeof(T); }
+
+inline unsigned long footprint(const Parameters *params)
+{
+    return sizeof(Parameters) + params->capacity() * sizeof(Type);
+}
+
+inline unsigned long characters(const void *) { return 0; }
+inline unsigned long characters(const Symbol *symbol) { return symbol->name().size() + 1; }
+inline unsigned long characters(const String *string) { return string->value().size() + 1; }
+
+
+/*
+ * Function:	create
+ *
+ * Description:	Allocate an object and count it, along with the characters
+ *		of its name or value.
+ */
+
+template<class T, class... Args>
+T *create(Args &&... args)
+{
+    T *object = new T(std::forward<Args>(args)...);
+
+    allocated(storage(object), footprint(object));
+
+    if (characters(object) > 0)
+	allocated(STRINGS, characters(object));
+
+    return object;
+}
+
+
+/*
+ * Function:	destroy
+ *
+ * Description:	Count an object as freed and free it, if there is one.
+ */
+
+template<class T>
+void destroy(T *object)
+{
+    if (object == nullptr)
+	return;
+
+    if (characters(object) > 0)
+	released(STRINGS, characters(object));
+
+    released(storage(object), footprint(object));
+    delete object;
+}
+
+# endif /* MEMORY_H */
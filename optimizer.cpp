@@ -0,0 +1,1317 @@
+/*
+ * File:	optimizer.cpp
+ *
+ * Description:	This file contains the public function definitions for
+ *		the tree optimizations of Simple C.  They run on the body of
+ *		each function after storage allocation and before code
+ *		generation, and rewrite the tree in place through the
+ *		subtrees returned by children().  They are enabled by -O.
+ *		Stripping works on the whole translation unit instead, and
+ *		is enabled by -fwhole-program.
+ *
+ *		Extra functionality:
+ *		- loop-invariant code motion for while and for loops
+ *		- local common subexpression elimination by value numbering
+ *		- removing unreachable code, constant tests, and dead stores
+ *		- stripping unused functions and globals from the whole
+ *		  translation unit
+ */
+
+# include <map>
+# include <string>
+# include <sstream>
+# include <cstdlib>
+# include <typeinfo>
+# include "optimizer.h"
+# include "lexer.h"
+# include "memory.h"
+
+using namespace std;
+
+typedef set<const Symbol *> SymbolSet;
+
+
+/* What a loop might change, and what it has hoisted so far.  A store is
+   any assignment that might change a value we read through a pointer:
+   one through a pointer or to a field, or one to a global or to a
+   variable whose address is taken.  Inherited expressions come whole
+   from the preheaders of inner loops and were counted there. */
+
+struct Loop {
+    SymbolSet assigned;
+    bool stores, calls;
+    Statements preheader;
+    unsigned inherited;
+};
+
+
+/* The values available at a point within a basic block, keyed by their
+   value numbers.  A key names the operation and the keys of its operands.
+   A variable's key includes how often it has been assigned, and a load's
+   key how often memory has been stored to, so a store or call simply
+   makes the old keys unreachable. */
+
+struct Values {
+    map<string, Expression *> available;
+    map<const Symbol *, unsigned> versions;
+    unsigned memory;
+};
+
+static thread_local SymbolSet addressed;
+static thread_local map<Expression *, Expression *> replaced;
+
+
+/*
+ * Function:	findAddressed
+ *
+ * Description:	Collect the variables whose address is taken anywhere in
+ *		the tree.
+ */
+
+void findAddressed(Statement *stmt, SymbolSet &symbols)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Identifier *id;
+
+
+    stmt->children(stmts, exprs);
+
+    if (dynamic_cast<Address *>(stmt) != nullptr)
+	if ((id = dynamic_cast<Identifier *>(*exprs[0])) != nullptr)
+	    symbols.insert(id->symbol());
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	findAddressed(*stmts[i], symbols);
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	findAddressed(*exprs[i], symbols);
+}
+
+
+/*
+ * Function:	isMemory
+ *
+ * Description:	Return whether a variable might be changed through a
+ *		pointer or by a called function: it is a global or its
+ *		address is taken.
+ */
+
+static bool isMemory(const Symbol *symbol)
+{
+    return symbol->_offset == 0 || addressed.count(symbol) > 0;
+}
+
+
+/*
+ * Function:	findEffects
+ *
+ * Description:	Record what the tree might change when it runs.
+ */
+
+static void findEffects(Statement *stmt, Loop &loop)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Identifier *id;
+
+
+    stmt->children(stmts, exprs);
+
+    if (dynamic_cast<Assignment *>(stmt) != nullptr) {
+	if ((id = dynamic_cast<Identifier *>(*exprs[0])) != nullptr) {
+	    loop.assigned.insert(id->symbol());
+	    loop.stores = loop.stores || isMemory(id->symbol());
+	} else
+	    loop.stores = true;
+
+    } else if (dynamic_cast<Call *>(stmt) != nullptr)
+	loop.calls = true;
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	findEffects(*stmts[i], loop);
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	findEffects(*exprs[i], loop);
+}
+
+
+/*
+ * Function:	isLeaf
+ *
+ * Description:	Return whether an expression generates no code of its
+ *		own, so there is nothing to gain by hoisting it.
+ */
+
+static bool isLeaf(Expression *expr)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    expr->children(stmts, exprs);
+
+    if (dynamic_cast<Address *>(expr) != nullptr) {
+	if (dynamic_cast<Dereference *>(*exprs[0]) == nullptr)
+	    return false;
+
+	expr = *exprs[0];
+	exprs.clear();
+	expr->children(stmts, exprs);
+	return isLeaf(*exprs[0]);
+    }
+
+    return exprs.empty();
+}
+
+
+/*
+ * Function:	isInvariant
+ *
+ * Description:	Return whether the value of an expression is the same on
+ *		every iteration of the loop.  If the expression might not
+ *		be evaluated at all, it must also be safe to evaluate
+ *		early: it may not load from memory or divide by anything
+ *		but a nonzero constant.
+ */
+
+static bool hasInvariantAddress(Expression *expr, const Loop &loop, bool speculative);
+
+static bool isInvariant(Expression *expr, const Loop &loop, bool speculative)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    const Symbol *symbol;
+    Number *divisor;
+    Reuse *reuse;
+
+
+    if (dynamic_cast<Identifier *>(expr) != nullptr) {
+	symbol = static_cast<Identifier *>(expr)->symbol();
+
+	if (!symbol->type().isScalar())
+	    return true;
+
+	if (loop.assigned.count(symbol) > 0)
+	    return false;
+
+	return !isMemory(symbol) || (!loop.stores && !loop.calls);
+    }
+
+    if ((reuse = dynamic_cast<Reuse *>(expr)) != nullptr)
+	return isInvariant(reuse->expr(), loop, false);
+
+    if (dynamic_cast<Call *>(expr) != nullptr)
+	return false;
+
+    expr->children(stmts, exprs);
+
+    if (dynamic_cast<Address *>(expr) != nullptr)
+	return hasInvariantAddress(*exprs[0], loop, speculative);
+
+    if (dynamic_cast<Dereference *>(expr) != nullptr)
+	if (speculative || loop.stores || loop.calls)
+	    return false;
+
+    if (dynamic_cast<Field *>(expr) != nullptr) {
+	if (speculative || loop.stores || loop.calls)
+	    return false;
+
+	return hasInvariantAddress(expr, loop, speculative);
+    }
+
+    if (dynamic_cast<Divide *>(expr) || dynamic_cast<Remainder *>(expr))
+	if (speculative) {
+	    divisor = dynamic_cast<Number *>(*exprs[1]);
+
+	    if (divisor == nullptr || strtol(divisor->value().c_str(), 0, 0) == 0)
+		return false;
+	}
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	if (!isInvariant(*exprs[i], loop, speculative))
+	    return false;
+
+    return true;
+}
+
+
+/*
+ * Function:	hasInvariantAddress
+ *
+ * Description:	Return whether the address of an lvalue (or of an array
+ *		or structure) is the same on every iteration of the loop.
+ */
+
+static bool hasInvariantAddress(Expression *expr, const Loop &loop, bool speculative)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    if (dynamic_cast<Identifier *>(expr) || dynamic_cast<String *>(expr))
+	return true;
+
+    expr->children(stmts, exprs);
+
+    if (dynamic_cast<Dereference *>(expr) != nullptr)
+	return isInvariant(*exprs[0], loop, speculative);
+
+    if (dynamic_cast<Field *>(expr) != nullptr)
+	return hasInvariantAddress(*exprs[0], loop, speculative);
+
+    return false;
+}
+
+
+/*
+ * Function:	hoistValue
+ *
+ * Description:	Hoist the largest invariant parts of an expression into
+ *		the preheader of the loop, leaving reuses of their values
+ *		behind.
+ */
+
+static void hoistAddress(Expression **slot, Loop &loop, bool speculative);
+static void hoistField(Expression **slot, Loop &loop, bool speculative);
+
+static void hoistValue(Expression **slot, Loop &loop, bool speculative)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Expression *expr = *slot;
+
+
+    if (!isLeaf(expr) && isInvariant(expr, loop, speculative)) {
+	loop.preheader.push_back(expr);
+	*slot = create<Reuse>(expr);
+	return;
+    }
+
+    if (dynamic_cast<Field *>(expr) != nullptr) {
+	hoistField(slot, loop, speculative);
+	return;
+    }
+
+    expr->children(stmts, exprs);
+
+    if (dynamic_cast<Address *>(expr) != nullptr)
+	hoistAddress(exprs[0], loop, speculative);
+
+    else if (dynamic_cast<LogicalAnd *>(expr) || dynamic_cast<LogicalOr *>(expr)) {
+	hoistValue(exprs[0], loop, speculative);
+	hoistValue(exprs[1], loop, true);
+
+    } else
+	for (unsigned i = 0; i < exprs.size(); i ++)
+	    hoistValue(exprs[i], loop, speculative);
+}
+
+
+/*
+ * Function:	hoistAddress
+ *
+ * Description:	Hoist the invariant parts of the address computation of
+ *		an lvalue, which itself is not evaluated as a value.
+ */
+
+static void hoistAddress(Expression **slot, Loop &loop, bool speculative)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    if (dynamic_cast<Field *>(*slot) != nullptr)
+	hoistField(slot, loop, speculative);
+
+    else if (dynamic_cast<Dereference *>(*slot) != nullptr) {
+	(*slot)->children(stmts, exprs);
+	hoistValue(exprs[0], loop, speculative);
+    }
+}
+
+
+/*
+ * Function:	hoistField
+ *
+ * Description:	Hoist the address computation of a field whose address
+ *		is invariant.  The field becomes a dereference of the
+ *		hoisted address, which works equally well as an lvalue.
+ */
+
+static void hoistField(Expression **slot, Loop &loop, bool speculative)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Expression *field = *slot, *address;
+    const Type &type = field->type();
+
+
+    if (type.isSimple() && hasInvariantAddress(field, loop, speculative)) {
+	address = create<Address>(field, Type(type.specifier(), type.indirection() + 1));
+	loop.preheader.push_back(address);
+	*slot = create<Dereference>(create<Reuse>(address), type);
+	return;
+    }
+
+    field->children(stmts, exprs);
+    hoistAddress(exprs[0], loop, speculative);
+}
+
+
+/*
+ * Function:	hoistStatement
+ *
+ * Description:	Hoist the invariant parts of the expressions within a
+ *		statement of the loop.  The statement might not run on any
+ *		given iteration, so everything we hoist must be safe to
+ *		evaluate early.  An expression statement, such as the
+ *		preheader of an inner loop, may be hoisted in its entirety.
+ */
+
+static void hoistStatement(Statement **slot, Loop &loop)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Expression *expr;
+
+
+    if ((expr = dynamic_cast<Expression *>(*slot)) != nullptr) {
+	hoistValue(&expr, loop, true);
+
+	if (expr != *slot && dynamic_cast<Reuse *>(expr) != nullptr)
+	    loop.inherited ++;
+
+	*slot = expr;
+	return;
+    }
+
+    (*slot)->children(stmts, exprs);
+
+    if (dynamic_cast<Assignment *>(*slot) != nullptr) {
+	hoistAddress(exprs[0], loop, true);
+	hoistValue(exprs[1], loop, true);
+
+    } else
+	for (unsigned i = 0; i < exprs.size(); i ++)
+	    hoistValue(exprs[i], loop, true);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	hoistStatement(stmts[i], loop);
+}
+
+
+/*
+ * Function:	hoistLoop
+ *
+ * Description:	Move the invariant computations of a while or for loop
+ *		into a preheader that runs once before the loop.  The test
+ *		runs at least once, so it may give up loads as well.  The
+ *		loop is replaced by a block of the preheader followed by
+ *		the loop itself.
+ */
+
+static unsigned hoistLoop(Statement **slot)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    unsigned count;
+    Loop loop;
+
+
+    loop.stores = false;
+    loop.calls = false;
+    loop.inherited = 0;
+    findEffects(*slot, loop);
+
+    (*slot)->children(stmts, exprs);
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	hoistValue(exprs[i], loop, false);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	hoistStatement(stmts[i], loop);
+
+    if (loop.preheader.empty())
+	return 0;
+
+    count = loop.preheader.size() - loop.inherited;
+    loop.preheader.push_back(*slot);
+    *slot = create<Block>(create<Scope>(nullptr), loop.preheader);
+    return count;
+}
+
+
+/*
+ * Function:	hoistNested
+ *
+ * Description:	Hoist the invariants of every loop within a statement,
+ *		innermost loops first, so that an outer loop can take
+ *		over what its inner loops hoisted.  A loop holding a case
+ *		label of an enclosing switch can be entered without running
+ *		a preheader, so nothing is hoisted out of it.
+ */
+
+static bool hasLabel(Statement *stmt);
+
+static unsigned hoistNested(Statement **slot)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    unsigned count = 0;
+
+
+    (*slot)->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	count += hoistNested(stmts[i]);
+
+    if ((dynamic_cast<While *>(*slot) || dynamic_cast<For *>(*slot)) && !hasLabel(*slot))
+	count += hoistLoop(slot);
+
+    return count;
+}
+
+
+/*
+ * Function:	hoistInvariants
+ *
+ * Description:	Perform loop-invariant code motion on the body of a
+ *		function and return the number of expressions hoisted.
+ */
+
+unsigned hoistInvariants(Statement *body)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    unsigned count = 0;
+
+
+    addressed.clear();
+    findAddressed(body, addressed);
+    body->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	count += hoistNested(stmts[i]);
+
+    return count;
+}
+
+
+/*
+ * Function:	addressKey
+ *
+ * Description:	Return the value number of the address of an lvalue (or
+ *		of an array or structure), or an empty string if it cannot
+ *		be compared.
+ */
+
+static string valueKey(Expression *expr, Values &values);
+
+static string addressKey(Expression *expr, Values &values)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    stringstream ss;
+    string base;
+
+
+    if (dynamic_cast<Identifier *>(expr) != nullptr) {
+	ss << "&" << static_cast<Identifier *>(expr)->symbol();
+	return ss.str();
+    }
+
+    if (dynamic_cast<String *>(expr) != nullptr)
+	return "\"" + static_cast<String *>(expr)->value();
+
+    expr->children(stmts, exprs);
+
+    if (dynamic_cast<Dereference *>(expr) != nullptr)
+	return valueKey(*exprs[0], values);
+
+    if (dynamic_cast<Field *>(expr) != nullptr) {
+	if ((base = addressKey(*exprs[0], values)).empty())
+	    return "";
+
+	ss << base << "+" << static_cast<Field *>(expr)->id()->symbol()->_offset;
+	return ss.str();
+    }
+
+    return "";
+}
+
+
+/*
+ * Function:	valueKey
+ *
+ * Description:	Return the value number of an expression, or an empty
+ *		string if it cannot be compared, as with a function call.
+ */
+
+static string valueKey(Expression *expr, Values &values)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    const Symbol *symbol;
+    stringstream ss;
+    string key;
+
+
+    if (dynamic_cast<Identifier *>(expr) != nullptr) {
+	symbol = static_cast<Identifier *>(expr)->symbol();
+	ss << symbol << "." << values.versions[symbol];
+
+	if (isMemory(symbol))
+	    ss << "@" << values.memory;
+
+	return ss.str();
+    }
+
+    if (dynamic_cast<Number *>(expr) != nullptr)
+	return "#" + static_cast<Number *>(expr)->value();
+
+    if (dynamic_cast<Character *>(expr) != nullptr)
+	return "'" + static_cast<Character *>(expr)->value();
+
+    if (dynamic_cast<String *>(expr) != nullptr)
+	return "\"" + static_cast<String *>(expr)->value();
+
+    if (dynamic_cast<Reuse *>(expr) != nullptr) {
+	ss << "=" << static_cast<Reuse *>(expr)->expr();
+	return ss.str();
+    }
+
+    if (dynamic_cast<Call *>(expr) != nullptr)
+	return "";
+
+    expr->children(stmts, exprs);
+
+    if (dynamic_cast<Address *>(expr) != nullptr) {
+	key = addressKey(*exprs[0], values);
+	return key.empty() ? "" : "&(" + key + ")";
+    }
+
+    if (dynamic_cast<Field *>(expr) != nullptr)
+	key = addressKey(expr, values);
+    else if (dynamic_cast<Dereference *>(expr) != nullptr)
+	key = valueKey(*exprs[0], values);
+
+    if (dynamic_cast<Field *>(expr) || dynamic_cast<Dereference *>(expr)) {
+	if (key.empty())
+	    return "";
+
+	ss << "*(" << key << ")" << expr->type() << "@" << values.memory;
+	return ss.str();
+    }
+
+    ss << typeid(*expr).name() << "<" << expr->type() << ">(";
+
+    for (unsigned i = 0; i < exprs.size(); i ++) {
+	if ((key = valueKey(*exprs[i], values)).empty())
+	    return "";
+
+	ss << (i > 0 ? "," : "") << key;
+    }
+
+    ss << ")";
+    return ss.str();
+}
+
+
+/*
+ * Function:	numberValue
+ *
+ * Description:	Replace an expression whose value is already available
+ *		in the basic block by a reuse of it.  Otherwise, number its
+ *		operands in the order they are generated and make its value
+ *		available.  Return the number of expressions replaced.
+ */
+
+static unsigned numberAddress(Expression **slot, Values &values);
+
+static unsigned numberValue(Expression **slot, Values &values)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Expression *expr = *slot;
+    unsigned count = 0;
+    Values right;
+    string key;
+
+
+    if (!isLeaf(expr) && !(key = valueKey(expr, values)).empty())
+	if (values.available.count(key) > 0) {
+	    replaced[expr] = values.available[key];
+	    *slot = create<Reuse>(values.available[key]);
+	    return 1;
+	}
+
+    expr->children(stmts, exprs);
+
+    if (dynamic_cast<Address *>(expr) || dynamic_cast<Field *>(expr))
+	count += numberAddress(exprs[0], values);
+
+    else if (dynamic_cast<LogicalAnd *>(expr) || dynamic_cast<LogicalOr *>(expr)) {
+	count += numberValue(exprs[0], values);
+	right = values;
+	count += numberValue(exprs[1], right);
+	values.memory = right.memory;
+
+    } else if (dynamic_cast<Call *>(expr) != nullptr) {
+	for (unsigned i = exprs.size(); i > 0; i --)
+	    count += numberValue(exprs[i - 1], values);
+
+	values.memory ++;
+
+    } else
+	for (unsigned i = 0; i < exprs.size(); i ++)
+	    count += numberValue(exprs[i], values);
+
+    if (!key.empty())
+	values.available[key] = expr;
+
+    return count;
+}
+
+
+/*
+ * Function:	numberAddress
+ *
+ * Description:	Number the operands of the address computation of an
+ *		lvalue, which itself is not evaluated as a value.
+ */
+
+static unsigned numberAddress(Expression **slot, Values &values)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    if (dynamic_cast<Dereference *>(*slot) || dynamic_cast<Field *>(*slot)) {
+	(*slot)->children(stmts, exprs);
+
+	if (dynamic_cast<Dereference *>(*slot) != nullptr)
+	    return numberValue(exprs[0], values);
+
+	return numberAddress(exprs[0], values);
+    }
+
+    return 0;
+}
+
+
+/*
+ * Function:	numberStatement
+ *
+ * Description:	Number the expressions of a statement.  Each basic block
+ *		starts with no values available: after a loop or if, and
+ *		at a case label.  The branches of an if and the body of a
+ *		while can still use the values of their test.
+ */
+
+static unsigned numberStatement(Statement **slot, Values &values)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Expression *expr;
+    Identifier *id;
+    unsigned count = 0;
+    Values branch;
+
+
+    if ((expr = dynamic_cast<Expression *>(*slot)) != nullptr) {
+	count = numberValue(&expr, values);
+	*slot = expr;
+	return count;
+    }
+
+    (*slot)->children(stmts, exprs);
+
+    if (dynamic_cast<Block *>(*slot) != nullptr) {
+	for (unsigned i = 0; i < stmts.size(); i ++)
+	    count += numberStatement(stmts[i], values);
+
+    } else if (dynamic_cast<Assignment *>(*slot) != nullptr) {
+	count += numberAddress(exprs[0], values);
+	count += numberValue(exprs[1], values);
+
+	if ((id = dynamic_cast<Identifier *>(*exprs[0])) != nullptr) {
+	    values.versions[id->symbol()] ++;
+
+	    if (isMemory(id->symbol()))
+		values.memory ++;
+	} else
+	    values.memory ++;
+
+    } else if (dynamic_cast<If *>(*slot) != nullptr) {
+	count += numberValue(exprs[0], values);
+
+	for (unsigned i = 0; i < stmts.size(); i ++) {
+	    branch = values;
+	    count += numberStatement(stmts[i], branch);
+	}
+
+	values.available.clear();
+
+    } else if (dynamic_cast<While *>(*slot) != nullptr) {
+	values.available.clear();
+	count += numberValue(exprs[0], values);
+	count += numberStatement(stmts[0], values);
+	values.available.clear();
+
+    } else if (dynamic_cast<Return *>(*slot) != nullptr) {
+	if (!exprs.empty())
+	    count += numberValue(exprs[0], values);
+
+	values.available.clear();
+
+    } else {
+	for (unsigned i = 0; i < exprs.size(); i ++) {
+	    values.available.clear();
+	    count += numberValue(exprs[i], values);
+	}
+
+	for (unsigned i = 0; i < stmts.size(); i ++) {
+	    values.available.clear();
+	    count += numberStatement(stmts[i], values);
+	}
+
+	values.available.clear();
+    }
+
+    return count;
+}
+
+
+/*
+ * Function:	redirect
+ *
+ * Description:	Point any reuse of an expression that was itself replaced
+ *		at the expression that replaced it instead.
+ */
+
+static void redirect(Statement **slot)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Expression *expr;
+    Reuse *reuse;
+
+
+    if ((reuse = dynamic_cast<Reuse *>(*slot)) != nullptr) {
+	expr = reuse->expr();
+
+	while (replaced.count(expr) > 0)
+	    expr = replaced[expr];
+
+	if (expr != reuse->expr())
+	    *slot = create<Reuse>(expr);
+
+	return;
+    }
+
+    (*slot)->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	redirect(stmts[i]);
+
+    for (unsigned i = 0; i < exprs.size(); i ++) {
+	Statement *stmt = *exprs[i];
+	redirect(&stmt);
+	*exprs[i] = static_cast<Expression *>(stmt);
+    }
+}
+
+
+/*
+ * Function:	eliminateCommon
+ *
+ * Description:	Perform local common subexpression elimination on the
+ *		body of a function and return the number of expressions
+ *		replaced by an earlier value.
+ */
+
+unsigned eliminateCommon(Statement *body)
+{
+    Values values;
+    unsigned count;
+
+
+    addressed.clear();
+    findAddressed(body, addressed);
+
+    replaced.clear();
+    values.memory = 0;
+    count = numberStatement(&body, values);
+
+    redirect(&body);
+    return count;
+}
+
+
+/*
+ * Function:	nothing
+ *
+ * Description:	Return a statement that does nothing, to stand in for one
+ *		that is removed.
+ */
+
+static Statement *nothing()
+{
+    return create<Block>(create<Scope>(nullptr), Statements());
+}
+
+
+/*
+ * Function:	isNothing
+ *
+ * Description:	Return whether a statement is one that does nothing.
+ */
+
+static bool isNothing(Statement *stmt)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    if (dynamic_cast<Block *>(stmt) == nullptr)
+	return false;
+
+    stmt->children(stmts, exprs);
+    return stmts.empty();
+}
+
+
+/*
+ * Function:	hasLabel
+ *
+ * Description:	Return whether the tree contains a case label belonging
+ *		to a switch outside of it, through which it can be reached
+ *		regardless of the code before it.
+ */
+
+static bool hasLabel(Statement *stmt)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    if (dynamic_cast<Case *>(stmt) != nullptr)
+	return true;
+
+    if (dynamic_cast<Switch *>(stmt) != nullptr)
+	return false;
+
+    stmt->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	if (hasLabel(*stmts[i]))
+	    return true;
+
+    return false;
+}
+
+
+/*
+ * Function:	hasCall
+ *
+ * Description:	Return whether the tree contains a function call.
+ */
+
+static bool hasCall(Statement *stmt)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+
+
+    if (dynamic_cast<Call *>(stmt) != nullptr)
+	return true;
+
+    stmt->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	if (hasCall(*stmts[i]))
+	    return true;
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	if (hasCall(*exprs[i]))
+	    return true;
+
+    return false;
+}
+
+
+/*
+ * Function:	terminates
+ *
+ * Description:	Return whether control never falls through to the end of
+ *		a statement, because every path through it returns or
+ *		breaks.
+ */
+
+static bool terminates(Statement *stmt)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    bool reachable = true;
+
+
+    if (dynamic_cast<Return *>(stmt) || dynamic_cast<Break *>(stmt))
+	return true;
+
+    stmt->children(stmts, exprs);
+
+    if (dynamic_cast<Block *>(stmt) != nullptr) {
+	for (unsigned i = 0; i < stmts.size(); i ++) {
+	    if (hasLabel(*stmts[i]))
+		reachable = true;
+
+	    if (reachable && terminates(*stmts[i]))
+		reachable = false;
+	}
+
+	return !reachable;
+    }
+
+    if (dynamic_cast<If *>(stmt) != nullptr)
+	return stmts.size() == 2 && terminates(*stmts[0]) && terminates(*stmts[1]);
+
+    return false;
+}
+
+
+/*
+ * Function:	fold
+ *
+ * Description:	Compute the value of an expression made only of constants
+ *		and return whether we could.  Division by zero is left for
+ *		run time.
+ */
+
+static bool fold(Expression *expr, long &value)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    long left, right;
+
+
+    if (dynamic_cast<Number *>(expr) != nullptr) {
+	value = strtol(static_cast<Number *>(expr)->value().c_str(), 0, 0);
+	return true;
+    }
+
+    if (dynamic_cast<Character *>(expr) != nullptr) {
+	value = charval(static_cast<Character *>(expr)->value());
+	return true;
+    }
+
+    expr->children(stmts, exprs);
+
+    if (exprs.size() == 1) {
+	if (!fold(*exprs[0], left))
+	    return false;
+
+	if (dynamic_cast<Not *>(expr) != nullptr)
+	    value = !left;
+	else if (dynamic_cast<Negate *>(expr) != nullptr)
+	    value = -left;
+	else if (dynamic_cast<Cast *>(expr) != nullptr)
+	    value = (expr->type().size() == 1 ? (signed char) left : left);
+	else
+	    return false;
+
+	return true;
+    }
+
+    if (exprs.size() != 2 || dynamic_cast<Call *>(expr) != nullptr)
+	return false;
+
+    if (!fold(*exprs[0], left) || !fold(*exprs[1], right))
+	return false;
+
+    if (dynamic_cast<Add *>(expr) != nullptr)
+	value = (int) (left + right);
+    else if (dynamic_cast<Subtract *>(expr) != nullptr)
+	value = (int) (left - right);
+    else if (dynamic_cast<Multiply *>(expr) != nullptr)
+	value = (int) (left * right);
+    else if (dynamic_cast<Divide *>(expr) != nullptr && right != 0)
+	value = left / right;
+    else if (dynamic_cast<Remainder *>(expr) != nullptr && right != 0)
+	value = left % right;
+    else if (dynamic_cast<LessThan *>(expr) != nullptr)
+	value = left < right;
+    else if (dynamic_cast<GreaterThan *>(expr) != nullptr)
+	value = left > right;
+    else if (dynamic_cast<LessOrEqual *>(expr) != nullptr)
+	value = left <= right;
+    else if (dynamic_cast<GreaterOrEqual *>(expr) != nullptr)
+	value = left >= right;
+    else if (dynamic_cast<Equal *>(expr) != nullptr)
+	value = left == right;
+    else if (dynamic_cast<NotEqual *>(expr) != nullptr)
+	value = left != right;
+    else if (dynamic_cast<LogicalAnd *>(expr) != nullptr)
+	value = left && right;
+    else if (dynamic_cast<LogicalOr *>(expr) != nullptr)
+	value = left || right;
+    else
+	return false;
+
+    return true;
+}
+
+
+/*
+ * Function:	removeUnreachable
+ *
+ * Description:	Remove the statements that can never run: those after a
+ *		return or break in a block, up to the next case label, and
+ *		the arms of if, while, and for statements whose tests are
+ *		constant.  Return the number of statements removed.
+ */
+
+static unsigned removeUnreachable(Statement **slot)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    unsigned count = 0;
+    bool reachable = true;
+    long value;
+
+
+    (*slot)->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	count += removeUnreachable(stmts[i]);
+
+    if (dynamic_cast<Block *>(*slot) != nullptr) {
+	for (unsigned i = 0; i < stmts.size(); i ++) {
+	    if (hasLabel(*stmts[i]))
+		reachable = true;
+
+	    if (!reachable) {
+		if (!isNothing(*stmts[i])) {
+		    *stmts[i] = nothing();
+		    count ++;
+		}
+
+	    } else if (terminates(*stmts[i]))
+		reachable = false;
+	}
+
+    } else if (dynamic_cast<If *>(*slot) != nullptr) {
+	if (fold(*exprs[0], value)) {
+	    if (value != 0 && (stmts.size() == 1 || !hasLabel(*stmts[1]))) {
+		*slot = *stmts[0];
+		count ++;
+
+	    } else if (value == 0 && !hasLabel(*stmts[0])) {
+		*slot = (stmts.size() == 2 ? *stmts[1] : nothing());
+		count ++;
+	    }
+	}
+
+    } else if (dynamic_cast<While *>(*slot) != nullptr) {
+	if (fold(*exprs[0], value) && value == 0 && !hasLabel(*stmts[0])) {
+	    *slot = nothing();
+	    count ++;
+	}
+
+    } else if (dynamic_cast<For *>(*slot) != nullptr) {
+	if (!exprs.empty() && fold(*exprs[0], value) && value == 0) {
+	    Statement *init = static_cast<For *>(*slot)->init();
+
+	    for (unsigned i = 0; i < stmts.size(); i ++)
+		if (hasLabel(*stmts[i]))
+		    return count;
+
+	    *slot = (init != nullptr ? init : nothing());
+	    count ++;
+	}
+    }
+
+    return count;
+}
+
+
+/*
+ * Function:	findReads
+ *
+ * Description:	Collect the variables whose values are read anywhere in
+ *		the tree, which is every use other than as the target of
+ *		an assignment.
+ */
+
+static void findReads(Statement *stmt, SymbolSet &reads)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Identifier *id;
+
+
+    if ((id = dynamic_cast<Identifier *>(stmt)) != nullptr)
+	reads.insert(id->symbol());
+
+    stmt->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	findReads(*stmts[i], reads);
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	if (i > 0 || dynamic_cast<Assignment *>(stmt) == nullptr)
+	    findReads(*exprs[i], reads);
+	else if (dynamic_cast<Identifier *>(*exprs[i]) == nullptr)
+	    findReads(*exprs[i], reads);
+}
+
+
+/*
+ * Function:	removeStores
+ *
+ * Description:	Remove the assignments to local variables that are never
+ *		read and whose address is never taken.  If the right-hand
+ *		side calls a function, it stays behind as an expression
+ *		statement.  Return the number of assignments removed.
+ */
+
+static unsigned removeStores(Statement **slot, const SymbolSet &reads)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    unsigned count = 0;
+    Identifier *id;
+
+
+    (*slot)->children(stmts, exprs);
+
+    if (dynamic_cast<Assignment *>(*slot) != nullptr) {
+	id = dynamic_cast<Identifier *>(*exprs[0]);
+
+	if (id == nullptr || isMemory(id->symbol()) || reads.count(id->symbol()) > 0)
+	    return 0;
+
+	*slot = (hasCall(*exprs[1]) ? *exprs[1] : nothing());
+	return 1;
+    }
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	count += removeStores(stmts[i], reads);
+
+    return count;
+}
+
+
+/*
+ * Function:	eliminateDead
+ *
+ * Description:	Remove unreachable code and dead stores from the body of
+ *		a function and return the number of statements removed.
+ *		Removing a store may leave another variable unread, so we
+ *		repeat until nothing changes.
+ */
+
+unsigned eliminateDead(Statement *body)
+{
+    SymbolSet reads;
+    unsigned count, removed;
+
+
+    addressed.clear();
+    findAddressed(body, addressed);
+    count = removeUnreachable(&body);
+
+    do {
+	reads.clear();
+	findReads(body, reads);
+	removed = removeStores(&body, reads);
+	count += removed;
+    } while (removed > 0);
+
+    return count;
+}
+
+
+/*
+ * Function:	findReferences
+ *
+ * Description:	Collect the names of the functions called and the globals
+ *		used in the tree.
+ */
+
+static void findReferences(Statement *stmt, const SymbolSet &globals, set<string> &callees, SymbolSet &used)
+{
+    Substatements stmts;
+    Subexpressions exprs;
+    Identifier *id;
+    Call *call;
+
+
+    if ((call = dynamic_cast<Call *>(stmt)) != nullptr)
+	callees.insert(call->symbol()->name());
+
+    else if ((id = dynamic_cast<Identifier *>(stmt)) != nullptr)
+	if (globals.count(id->symbol()) > 0)
+	    used.insert(id->symbol());
+
+    stmt->children(stmts, exprs);
+
+    for (unsigned i = 0; i < stmts.size(); i ++)
+	findReferences(*stmts[i], globals, callees, used);
+
+    for (unsigned i = 0; i < exprs.size(); i ++)
+	findReferences(*exprs[i], globals, callees, used);
+}
+
+
+/*
+ * Function:	stripUnreachable
+ *
+ * Description:	Remove the function definitions and global variables that
+ *		cannot be reached from the given roots, following calls
+ *		through the call graph.  Both lists stay in source order.
+ *		Functions that are only declared need nothing removed.
+ */
+
+void stripUnreachable(Functions &functions, Symbols &globals, const set<string> &roots)
+{
+    map<string, Function *> defined;
+    set<string> callees, reached;
+    vector<string> pending;
+    Functions reachable;
+    Symbols referenced;
+    SymbolSet all, used;
+    Function *function;
+    string name;
+
+
+    for (unsigned i = 0; i < functions.size(); i ++)
+	defined[functions[i]->symbol()->name()] = functions[i];
+
+    all.insert(globals.begin(), globals.end());
+    pending.assign(roots.begin(), roots.end());
+
+    while (!pending.empty()) {
+	name = pending.back();
+	pending.pop_back();
+
+	if (!reached.insert(name).second || defined.count(name) == 0)
+	    continue;
+
+	function = defined[name];
+	callees.clear();
+	findReferences(function->body(), all, callees, used);
+	pending.insert(pending.end(), callees.begin(), callees.end());
+    }
+
+    for (unsigned i = 0; i < functions.size(); i ++)
+	if (reached.count(functions[i]->symbol()->name()) > 0)
+	    reachable.push_back(functions[i]);
+
+    for (unsigned i = 0; i < globals.size(); i ++)
+	if (used.count(globals[i]) > 0)
+	    referenced.push_back(globals[i]);
+
+    functions = reachable;
+    globals = referenced;
+}
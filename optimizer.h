@@ -0,0 +1,22 @@
+/*
+ * File:	optimizer.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		the tree optimizations of Simple C.
+ */
+
+# ifndef OPTIMIZER_H
+# define OPTIMIZER_H
+# include <set>
+# include <string>
+# include "Tree.h"
+
+void findAddressed(Statement *stmt, std::set<const Symbol *> &symbols);
+unsigned eliminateDead(Statement *body);
+unsigned hoistInvariants(Statement *body);
+unsigned eliminateCommon(Statement *body);
+
+void stripUnreachable(Functions &functions, Symbols &globals,
+	const std::set<std::string> &roots);
+
+# endif /* OPTIMIZER_H */
@@ -0,0 +1,242 @@
+/*
+ * File:	options.cpp
+ *
+ * Description:	This file contains the public function and variable
+ *		definitions for the command-line options of Simple C.  The
+ *		compiler still reads the program from the standard input
+ *		and writes assembly to the standard output; the options
+ *		only control how the code is generated.
+ *
+ *		-O			optimize the tree before generating
+ *					code (see optimizer.cpp)
+ *		-fopt-report		report what the optimizer did for
+ *					each function on the standard error
+ *		-fmem-report		report the storage of the compiler
+ *					and of each function on the
+ *					standard error (see memory.cpp)
+ *		-fcode-report		report the instructions, memory
+ *					accesses, frame size, and static
+ *					cycle estimate of each function on
+ *					the standard error (see cost.cpp)
+ *		-funroll-loops[=N]	unroll counted for loops N times
+ *					(default 4)
+ *		-fwhole-program		generate only the functions and
+ *					globals reachable from main and
+ *					the exported functions
+ *		-fexport=NAME		keep function NAME as well
+ *		-jN			generate N functions at a time; the
+ *					output is the same for any N
+ *		-fpipeline		lex, parse, and generate code on
+ *					separate threads (see pipeline.cpp)
+ *		-finstrument		count the entries to each basic
+ *					block; link with lib/profile.o to
+ *					write the counts to a profile
+ *		-fprofile-use=FILE	lay out branches and loops for the
+ *					block counts in FILE, written by a
+ *					program compiled with -finstrument
+ *					and the same other options
+ *		-g			emit the line of each statement and
+ *					the type and size of each function,
+ *					so that profilers and debuggers can
+ *					find the source
+ *		-fsource-name=FILE	name the source FILE in the line
+ *					information (default <stdin>)
+ *		-finstrument-functions	call a hook on entry to and exit
+ *					from each function, with its address
+ *					and call site; link with lib/calls.o
+ *					to count calls and time them
+ *		-fentry-hook=NAME	call NAME on entry (default
+ *					__cyg_profile_func_enter)
+ *		-fexit-hook=NAME	call NAME on exit (default
+ *					__cyg_profile_func_exit)
+ *		-m32			generate code for i386, with four-byte
+ *					pointers and arguments on the stack
+ *					(the default)
+ *		-m64			generate code for x86-64 System V,
+ *					with eight-byte pointers, the first
+ *					six arguments in registers, and a
+ *					stack aligned to sixteen bytes
+ *		-fcache[=DIR]		look up and keep compiled programs
+ *					and functions in DIR (default
+ *					$SCC_CACHE_DIR, or else ~/.cache/scc;
+ *					see cache.cpp and incremental.cpp)
+ *		-fcache-size=N		keep at most N megabytes in the
+ *					cache (default 256)
+ *		-fcache-stats		report the statistics of the cache;
+ *					implies -fcache
+ *		-ftime-report[=json]	report the calls and time of each
+ *					phase on the standard error, as a
+ *					table or as JSON, if the compiler
+ *					was built with TIMING (see timing.h)
+ */
+
+# include <string>
+# include <cstdlib>
+# include <iostream>
+# include "options.h"
+
+using namespace std;
+
+
+/*
+ * Function:	Options::Options (constructor)
+ *
+ * Description:	Initialize the options to their defaults, which generate
+ *		every function as written, one after another.
+ */
+
+Options::Options()
+    : unrollFactor(1), jobs(1), optimize(false), optimizeReport(false),
+      memoryReport(false), codeReport(false),
+      wholeProgram(false), pipelined(false), instrument(false), debug(false),
+      instrumentFunctions(false), cacheSize(256), cacheStats(false),
+      sourceName("<stdin>"), entryHook("__cyg_profile_func_enter"),
+      exitHook("__cyg_profile_func_exit"), target("i386")
+{
+}
+
+
+/*
+ * Function:	defaultCache
+ *
+ * Description:	Return the directory of the cache when none is given.
+ */
+
+static string defaultCache()
+{
+    const char *dir;
+
+    if ((dir = getenv("SCC_CACHE_DIR")) != nullptr && *dir != '\0')
+	return dir;
+
+    if ((dir = getenv("HOME")) != nullptr && *dir != '\0')
+	return string(dir) + "/.cache/scc";
+
+    return "/tmp/scc-cache";
+}
+
+
+/*
+ * Function:	usage
+ *
+ * Description:	Report an unrecognized option and exit.
+ */
+
+static void usage(const string &arg)
+{
+    cerr << "scc: unrecognized option '" << arg << "'" << endl;
+    cerr << "usage: scc [-O] [-fopt-report] [-funroll-loops[=N]]";
+    cerr << " [-fwhole-program] [-fexport=NAME]... [-jN]";
+    cerr << " [-fpipeline] [-finstrument] [-fprofile-use=FILE] [-g]";
+    cerr << " [-fsource-name=FILE] [-finstrument-functions]";
+    cerr << " [-fentry-hook=NAME] [-fexit-hook=NAME] [-m32] [-m64]";
+    cerr << " [-fcache[=DIR]] [-fcache-size=N] [-fcache-stats]";
+    cerr << " < input.c > output.s";
+    cerr << endl;
+    exit(EXIT_FAILURE);
+}
+
+
+/*
+ * Function:	value
+ *
+ * Description:	Return the positive number following the '=' in an
+ *		option, or the default if there is none.
+ */
+
+static unsigned value(const string &arg, size_t length, unsigned deflt)
+{
+    char *end;
+    unsigned long n;
+
+
+    if (arg.size() == length)
+	return deflt;
+
+    if (arg[length] != '=')
+	usage(arg);
+
+    n = strtoul(arg.c_str() + length + 1, &end, 10);
+
+    if (*end != '\0' || n == 0)
+	usage(arg);
+
+    return n;
+}
+
+
+/*
+ * Function:	parseOptions
+ *
+ * Description:	Parse the command-line options into OPTIONS.
+ */
+
+void parseOptions(int argc, char *argv[], Options &options)
+{
+    static const string unroll = "-funroll-loops";
+    static const string exportOpt = "-fexport=";
+    static const string cacheSize = "-fcache-size";
+    static const string profileUse = "-fprofile-use=";
+    static const string sourceName = "-fsource-name=";
+    static const string entryHook = "-fentry-hook=";
+    static const string exitHook = "-fexit-hook=";
+
+
+    for (int i = 1; i < argc; i ++) {
+	string arg = argv[i];
+
+	if (arg == "-O")
+	    options.optimize = true;
+	else if (arg == "-fopt-report")
+	    options.optimizeReport = true;
+	else if (arg == "-fmem-report")
+	    options.memoryReport = true;
+	else if (arg == "-fcode-report")
+	    options.codeReport = true;
+	else if (arg.compare(0, unroll.size(), unroll) == 0)
+	    options.unrollFactor = value(arg, unroll.size(), 4);
+	else if (arg == "-fwhole-program")
+	    options.wholeProgram = true;
+	else if (arg.compare(0, exportOpt.size(), exportOpt) == 0)
+	    options.exported.insert(arg.substr(exportOpt.size()));
+	else if (arg == "-fpipeline")
+	    options.pipelined = true;
+	else if (arg == "-finstrument")
+	    options.instrument = true;
+	else if (arg.compare(0, profileUse.size(), profileUse) == 0 && arg.size() > profileUse.size())
+	    options.profileFile = arg.substr(profileUse.size());
+	else if (arg == "-g")
+	    options.debug = true;
+	else if (arg.compare(0, sourceName.size(), sourceName) == 0 && arg.size() > sourceName.size())
+	    options.sourceName = arg.substr(sourceName.size());
+	else if (arg == "-finstrument-functions")
+	    options.instrumentFunctions = true;
+	else if (arg.compare(0, entryHook.size(), entryHook) == 0 && arg.size() > entryHook.size())
+	    options.entryHook = arg.substr(entryHook.size());
+	else if (arg.compare(0, exitHook.size(), exitHook) == 0 && arg.size() > exitHook.size())
+	    options.exitHook = arg.substr(exitHook.size());
+	else if (arg == "-m32")
+	    options.target = "i386";
+	else if (arg == "-m64")
+	    options.target = "x86_64";
+	else if (arg.compare(0, cacheSize.size(), cacheSize) == 0)
+	    options.cacheSize = value(arg, cacheSize.size(), 256);
+	else if (arg == "-fcache-stats")
+	    options.cacheStats = true;
+	else if (arg == "-ftime-report")
+	    options.timeReport = "table";
+	else if (arg == "-ftime-report=json")
+	    options.timeReport = "json";
+	else if (arg == "-fcache")
+	    options.cacheDirectory = defaultCache();
+	else if (arg.compare(0, 8, "-fcache=") == 0 && arg.size() > 8)
+	    options.cacheDirectory = arg.substr(8);
+	else if (arg.compare(0, 2, "-j") == 0 && arg.size() > 2)
+	    options.jobs = value("-j=" + arg.substr(2), 2, 1);
+	else
+	    usage(arg);
+    }
+
+    if (options.cacheStats && options.cacheDirectory.empty())
+	options.cacheDirectory = defaultCache();
+}
@@ -0,0 +1,35 @@
+/*
+ * File:	options.h
+ *
+ * Description:	This file contains the public function and variable
+ *		declarations for the options of Simple C.
+ */
+
+# ifndef OPTIONS_H
+# define OPTIONS_H
+# include <set>
+# include <string>
+
+struct Options {
+    unsigned unrollFactor, jobs;
+    bool optimize, optimizeReport, memoryReport, codeReport;
+    bool wholeProgram, pipelined, instrument, debug;
+    bool instrumentFunctions;
+    std::set<std::string> exported;
+
+    std::string cacheDirectory;
+    unsigned cacheSize;
+    bool cacheStats;
+
+    std::string timeReport;
+    std::string profileFile;
+    std::string sourceName;
+    std::string entryHook, exitHook;
+    std::string target;
+
+    Options();
+};
+
+void parseOptions(int argc, char *argv[], Options &options);
+
+# endif /* OPTIONS_H */
@@ -12,33 +12,50 @@
 # include "tokens.h"
 # include "checker.h"
 # include "generator.h"
+# include "optimizer.h"
+# include "pipeline.h"
+# include "incremental.h"
+# include "parser.h"
+# include "compiler.h"
+# include "memory.h"
+# include "timing.h"
 
 using namespace std;
 
-static int lookahead, nexttoken;
-static string lexbuf, nextbuf;
+struct SyntaxError {};
 
-static Type returnType;
 static Expression *expression();
 static Statement *statement();
 
-static Symbols globals;
-
 
 /*
  * Function:	error
  *
- * Description:	Report a syntax error to standard error.
+ * Description:	Report a syntax error and abandon the compilation, since
+ *		our parser does not do error recovery.
  */
 
 static void error()
 {
-    if (lookahead == DONE)
+    if (compiler->lookahead == DONE)
 	report("syntax error at end of file");
     else
-	report("syntax error at '%s'", lexbuf);
+	report("syntax error at '%s'", compiler->lexbuf);
+
+    throw SyntaxError();
+}
+
+
+/*
+ * Function:	scan
+ *
+ * Description:	Return the next token in the input stream, either from the
+ *		lexer directly or from the lexer thread of the pipeline.
+ */
 
-    exit(EXIT_FAILURE);
+static int scan(string &buf)
+{
+    return compiler->options.pipelined ? nextToken(buf) : lexan(buf);
 }
 
 
@@ -52,15 +69,18 @@ static void error()
 
 static void match(int t)
 {
-    if (lookahead != t)
+    if (compiler->lookahead != t)
 	error();
 
-    if (nexttoken) {
-	lookahead = nexttoken;
-	lexbuf = nextbuf;
-	nexttoken = 0;
+    if (compiler->cache != nullptr)
+	recordToken(compiler->lookahead, compiler->lexbuf);
+
+    if (compiler->nexttoken) {
+	compiler->lookahead = compiler->nexttoken;
+	compiler->lexbuf = compiler->nextbuf;
+	compiler->nexttoken = 0;
     } else
-	lookahead = lexan(lexbuf);
+	compiler->lookahead = scan(compiler->lexbuf);
 }
 
 
@@ -73,10 +93,10 @@ static void match(int t)
 
 static int peek()
 {
-    if (!nexttoken)
-	nexttoken = lexan(nextbuf);
+    if (!compiler->nexttoken)
+	compiler->nexttoken = scan(compiler->nextbuf);
 
-    return nexttoken;
+    return compiler->nexttoken;
 }
 
 
@@ -91,7 +111,7 @@ static int peek()
 
 static string expect(int t)
 {
-    string buf = lexbuf;
+    string buf = compiler->lexbuf;
     match(t);
     return buf;
 }
@@ -135,8 +155,8 @@ static bool isSpecifier(int token)
 
 static string specifier()
 {
-    if (lookahead == INT || lookahead == CHAR)
-	return expect(lookahead);
+    if (compiler->lookahead == INT || compiler->lookahead == CHAR)
+	return expect(compiler->lookahead);
 
     match(STRUCT);
     return expect(ID);
@@ -158,7 +178,7 @@ static unsigned pointers()
     unsigned count = 0;
 
 
-    while (lookahead == '*') {
+    while (compiler->lookahead == '*') {
 	match('*');
 	count ++;
     }
@@ -187,7 +207,7 @@ static void declarator(const string &typespec)
     indirection = pointers();
     name = expect(ID);
 
-    if (lookahead == '[') {
+    if (compiler->lookahead == '[') {
 	match('[');
 	declareVariable(name, Type(typespec, indirection, number()));
 	match(']');
@@ -220,7 +240,7 @@ static void declaration()
     typespec = specifier();
     declarator(typespec);
 
-    while (lookahead == ',') {
+    while (compiler->lookahead == ',') {
 	match(',');
 	declarator(typespec);
     }
@@ -241,7 +261,7 @@ static void declaration()
 
 static void declarations()
 {
-    while (isSpecifier(lookahead))
+    while (isSpecifier(compiler->lookahead))
 	declaration();
 }
 
@@ -272,30 +292,30 @@ static Expression *primaryExpression()
     Expressions args;
 
 
-    if (lookahead == '(') {
+    if (compiler->lookahead == '(') {
 	match('(');
 	expr = expression();
 	match(')');
 
-    } else if (lookahead == CHARACTER) {
-	expr = new Character(expect(CHARACTER));
+    } else if (compiler->lookahead == CHARACTER) {
+	expr = create<Character>(expect(CHARACTER));
 
-    } else if (lookahead == STRING) {
-	expr = new String(expect(STRING));
+    } else if (compiler->lookahead == STRING) {
+	expr = create<String>(expect(STRING));
 
-    } else if (lookahead == NUM) {
-	expr = new Number(expect(NUM));
+    } else if (compiler->lookahead == NUM) {
+	expr = create<Number>(expect(NUM));
 
-    } else if (lookahead == ID) {
+    } else if (compiler->lookahead == ID) {
 	symbol = checkIdentifier(expect(ID));
 
-	if (lookahead == '(') {
+	if (compiler->lookahead == '(') {
 	    match('(');
 
-	    if (lookahead != ')') {
+	    if (compiler->lookahead != ')') {
 		args.push_back(expression());
 
-		while (lookahead == ',') {
+		while (compiler->lookahead == ',') {
 		    match(',');
 		    args.push_back(expression());
 		}
@@ -305,7 +325,7 @@ static Expression *primaryExpression()
 	    match(')');
 
 	} else
-	    expr = new Identifier(symbol);
+	    expr = create<Identifier>(symbol);
 
     } else {
 	expr = nullptr;
@@ -336,17 +356,17 @@ static Expression *postfixExpression()
     left = primaryExpression();
 
     while (1) {
-	if (lookahead == '[') {
+	if (compiler->lookahead == '[') {
 	    match('[');
 	    right = expression();
 	    left = checkArray(left, right);
 	    match(']');
 
-	} else if (lookahead == '.') {
+	} else if (compiler->lookahead == '.') {
 	    match('.');
 	    left = checkDirectField(left, expect(ID));
 
-	} else if (lookahead == ARROW) {
+	} else if (compiler->lookahead == ARROW) {
 	    match(ARROW);
 	    left = checkIndirectField(left, expect(ID));
 
@@ -380,30 +400,30 @@ static Expression *prefixExpression()
     string typespec;
 
 
-    if (lookahead == '!') {
+    if (compiler->lookahead == '!') {
 	match('!');
 	expr = prefixExpression();
 	expr = checkNot(expr);
 
-    } else if (lookahead == '-') {
+    } else if (compiler->lookahead == '-') {
 	match('-');
 	expr = prefixExpression();
 	expr = checkNegate(expr);
 
-    } else if (lookahead == '*') {
+    } else if (compiler->lookahead == '*') {
 	match('*');
 	expr = prefixExpression();
 	expr = checkDereference(expr);
 
-    } else if (lookahead == '&') {
+    } else if (compiler->lookahead == '&') {
 	match('&');
 	expr = prefixExpression();
 	expr = checkAddress(expr);
 
-    } else if (lookahead == SIZEOF) {
+    } else if (compiler->lookahead == SIZEOF) {
 	match(SIZEOF);
 
-	if (lookahead == '(' && isSpecifier(peek())) {
+	if (compiler->lookahead == '(' && isSpecifier(peek())) {
 	    match('(');
 	    typespec = specifier();
 	    indirection = pointers();
@@ -441,7 +461,7 @@ static Expression *castExpression()
     string typespec;
 
 
-    if (lookahead == '(' && isSpecifier(peek())) {
+    if (compiler->lookahead == '(' && isSpecifier(peek())) {
 	match('(');
 	typespec = specifier();
 	indirection = pointers();
@@ -476,17 +496,17 @@ static Expression *multiplicativeExpression()
     left = castExpression();
 
     while (1) {
-	if (lookahead == '*') {
+	if (compiler->lookahead == '*') {
 	    match('*');
 	    right = castExpression();
 	    left = checkMultiply(left, right);
 
-	} else if (lookahead == '/') {
+	} else if (compiler->lookahead == '/') {
 	    match('/');
 	    right = castExpression();
 	    left = checkDivide(left, right);
 
-	} else if (lookahead == '%') {
+	} else if (compiler->lookahead == '%') {
 	    match('%');
 	    right = castExpression();
 	    left = checkRemainder(left, right);
@@ -518,12 +538,12 @@ static Expression *additiveExpression()
     left = multiplicativeExpression();
 
     while (1) {
-	if (lookahead == '+') {
+	if (compiler->lookahead == '+') {
 	    match('+');
 	    right = multiplicativeExpression();
 	    left = checkAdd(left, right);
 
-	} else if (lookahead == '-') {
+	} else if (compiler->lookahead == '-') {
 	    match('-');
 	    right = multiplicativeExpression();
 	    left = checkSubtract(left, right);
@@ -559,22 +579,22 @@ static Expression *relationalExpression()
     left = additiveExpression();
 
     while (1) {
-	if (lookahead == '<') {
+	if (compiler->lookahead == '<') {
 	    match('<');
 	    right = additiveExpression();
 	    left = checkLessThan(left, right);
 
-	} else if (lookahead == '>') {
+	} else if (compiler->lookahead == '>') {
 	    match('>');
 	    right = additiveExpression();
 	    left = checkGreaterThan(left, right);
 
-	} else if (lookahead == LEQ) {
+	} else if (compiler->lookahead == LEQ) {
 	    match(LEQ);
 	    right = additiveExpression();
 	    left = checkLessOrEqual(left, right);
 
-	} else if (lookahead == GEQ) {
+	} else if (compiler->lookahead == GEQ) {
 	    match(GEQ);
 	    right = additiveExpression();
 	    left = checkGreaterOrEqual(left, right);
@@ -606,12 +626,12 @@ static Expression *equalityExpression()
     left = relationalExpression();
 
     while (1) {
-	if (lookahead == EQL) {
+	if (compiler->lookahead == EQL) {
 	    match(EQL);
 	    right = relationalExpression();
 	    left = checkEqual(left, right);
 
-	} else if (lookahead == NEQ) {
+	} else if (compiler->lookahead == NEQ) {
 	    match(NEQ);
 	    right = relationalExpression();
 	    left = checkNotEqual(left, right);
@@ -642,7 +662,7 @@ static Expression *logicalAndExpression()
 
     left = equalityExpression();
 
-    while (lookahead == AND) {
+    while (compiler->lookahead == AND) {
 	match(AND);
 	right = equalityExpression();
 	left = checkLogicalAnd(left, right);
@@ -671,7 +691,7 @@ static Expression *expression()
 
     left = logicalAndExpression();
 
-    while (lookahead == OR) {
+    while (compiler->lookahead == OR) {
 	match(OR);
 	right = logicalAndExpression();
 	left = checkLogicalOr(left, right);
@@ -699,13 +719,82 @@ static Statements statements()
     Statements stmts;
 
 
-    while (lookahead != '}')
+    while (compiler->lookahead != '}')
 	stmts.push_back(statement());
 
     return stmts;
 }
 
 
+/*
+ * Function:	assignment
+ *
+ * Description:	Parse an assignment or expression statement, but not the
+ *		terminating semicolon, since these also appear in the
+ *		header of a for statement.
+ *
+ *		assignment:
+ *		  expression = expression
+ *		  expression
+ */
+
+static Statement *assignment()
+{
+    Expression *expr;
+
+
+    expr = expression();
+
+    if (compiler->lookahead == '=') {
+	match('=');
+	return checkAssignment(expr, expression());
+    }
+
+    return expr;
+}
+
+
+/*
+ * Function:	caseValue
+ *
+ * Description:	Parse the value of a case label, which in Simple C must
+ *		be an integer or character literal, optionally negated.
+ */
+
+static long caseValue()
+{
+    if (compiler->lookahead == CHARACTER)
+	return charval(expect(CHARACTER));
+
+    if (compiler->lookahead == '-') {
+	match('-');
+	return -(long) number();
+    }
+
+    return number();
+}
+
+
+/*
+ * Function:	noteLine
+ *
+ * Description:	Note the line on which a statement starts, for the line
+ *		information generated with -g, and return the statement.
+ *		The code generator may already be reading the lines of
+ *		earlier functions on another thread.
+ */
+
+static Statement *noteLine(Statement *stmt, int line)
+{
+    if (compiler->options.debug && stmt != nullptr) {
+	lock_guard<mutex> lock(compiler->linesLock);
+	compiler->lines[stmt] = line;
+    }
+
+    return stmt;
+}
+
+
 /*
  * Function:	statement
  *
@@ -716,74 +805,128 @@ static Statements statements()
  *		  { declarations statements }
  *		  return expression ;
  *		  while ( expression ) statement
+ *		  for ( assignment-opt ; expression-opt ; assignment-opt ) statement
  *		  if ( expression ) statement
  *		  if ( expression ) statement else statement
- *		  expression = expression ;
- *		  expression ;
+ *		  switch ( expression ) statement
+ *		  case case-value :
+ *		  default :
+ *		  break ;
+ *		  assignment ;
+ *
+ *		case-value:
+ *		  num
+ *		  - num
+ *		  character
  */
 
 static Statement *statement()
 {
     Scope *decls;
-    Statement *stmt;
+    Statement *stmt, *init, *incr;
     Statements stmts;
     Expression *expr;
+    int line = compiler->lineno;
 
 
-    if (lookahead == '{') {
+    if (compiler->lookahead == '{') {
 	match('{');
 	openScope();
 	declarations();
 	stmts = statements();
 	decls = closeScope();
 	match('}');
-	return new Block(decls, stmts);
+	return noteLine(create<Block>(decls, stmts), line);
     }
 
-    if (lookahead == RETURN) {
+    if (compiler->lookahead == RETURN) {
 	match(RETURN);
 	expr = expression();
-	checkReturn(expr, returnType);
+	checkReturn(expr, compiler->returnType);
 	match(';');
-	return new Return(expr);
+	return noteLine(create<Return>(expr), line);
     }
 
-    if (lookahead == WHILE) {
+    if (compiler->lookahead == WHILE) {
 	match(WHILE);
 	match('(');
 	expr = expression();
 	checkTest(expr);
 	match(')');
+	openLoop();
 	stmt = statement();
-	return new While(expr, stmt);
+	closeLoop();
+	return noteLine(create<While>(expr, stmt), line);
     }
 
-    if (lookahead == IF) {
-	match(IF);
+    if (compiler->lookahead == FOR) {
+	match(FOR);
+	match('(');
+	init = (compiler->lookahead != ';' ? assignment() : nullptr);
+	match(';');
+	expr = nullptr;
+
+	if (compiler->lookahead != ';') {
+	    expr = expression();
+	    checkTest(expr);
+	}
+
+	match(';');
+	incr = (compiler->lookahead != ')' ? assignment() : nullptr);
+	match(')');
+	openLoop();
+	stmt = statement();
+	closeLoop();
+	return noteLine(create<For>(init, expr, incr, stmt), line);
+    }
+
+    if (compiler->lookahead == SWITCH) {
+	match(SWITCH);
 	match('(');
 	expr = expression();
-	checkTest(expr);
+	openSwitch(expr);
 	match(')');
 	stmt = statement();
+	return noteLine(closeSwitch(expr, stmt), line);
+    }
 
-	if (lookahead != ELSE)
-	    return new If(expr, stmt, nullptr);
+    if (compiler->lookahead == CASE) {
+	match(CASE);
+	stmt = checkCase(caseValue());
+	match(':');
+	return noteLine(stmt, line);
+    }
 
-	match(ELSE);
-	return new If(expr, stmt, statement());
+    if (compiler->lookahead == DEFAULT) {
+	match(DEFAULT);
+	match(':');
+	return noteLine(checkDefault(), line);
     }
 
-    expr = expression();
+    if (compiler->lookahead == BREAK) {
+	match(BREAK);
+	match(';');
+	return noteLine(checkBreak(), line);
+    }
 
-    if (lookahead == '=') {
-	match('=');
-	stmt = checkAssignment(expr, expression());
+    if (compiler->lookahead == IF) {
+	match(IF);
+	match('(');
+	expr = expression();
+	checkTest(expr);
+	match(')');
+	stmt = statement();
 
-    } else
-	stmt = expr;
+	if (compiler->lookahead != ELSE)
+	    return noteLine(create<If>(expr, stmt, nullptr), line);
 
+	match(ELSE);
+	return noteLine(create<If>(expr, stmt, statement()), line);
+    }
+
+    stmt = assignment();
     match(';');
-    return stmt;
+    return noteLine(stmt, line);
 }
 
 
@@ -829,21 +972,22 @@ static Type parameter()
 
 static Parameters *parameters()
 {
-    Parameters *params = new Parameters();
+    Parameters *params = create<Parameters>();
 
 
-    if (lookahead == VOID)
+    if (compiler->lookahead == VOID)
 	match(VOID);
 
     else {
 	params->push_back(parameter());
 
-	while (lookahead == ',') {
+	while (compiler->lookahead == ',') {
 	    match(',');
 	    params->push_back(parameter());
 	}
     }
 
+    allocated(PARAMETERS, params->capacity() * sizeof(Type), 0);
     return params;
 }
 
@@ -882,11 +1026,15 @@ static void topLevelDeclaration()
     Statements stmts;
     Symbol *symbol;
     Scope *decls;
+    int line;
 
 
+    compiler->span.clear();
+    line = compiler->lineno;
+    compiler->memory.declaration = Usage();
     typespec = specifier();
 
-    if (typespec != "int" && typespec != "char" && lookahead == '{') {
+    if (typespec != "int" && typespec != "char" && compiler->lookahead == '{') {
 	match('{');
 	openScope();
 	declaration();
@@ -899,61 +1047,72 @@ static void topLevelDeclaration()
 	indirection = pointers();
 	name = expect(ID);
 
-	if (lookahead == '[') {
+	if (compiler->lookahead == '[') {
 	    match('[');
 	    symbol = declareVariable(name, Type(typespec, indirection, number()));
-	    globals.push_back(symbol);
+	    compiler->globals.push_back(symbol);
 	    match(']');
 
-	} else if (lookahead == '(') {
+	} else if (compiler->lookahead == '(') {
 	    match('(');
 
-	    if (lookahead == ')') {
+	    if (compiler->lookahead == ')') {
 		match(')');
 		declareFunction(name, Type(typespec, indirection, nullptr));
 
 	    } else {
 		openScope();
-		returnType = Type(typespec, indirection);
+		compiler->returnType = Type(typespec, indirection);
 		symbol = defineFunction(name, Type(typespec, indirection, parameters()));
 		match(')');
 		match('{');
 		declarations();
 		stmts = statements();
 		decls = closeScope();
-		function = new Function(symbol, new Block(decls, stmts));
+		function = create<Function>(symbol, create<Block>(decls, stmts));
+		noteLine(function->body(), line);
 		match('}');
 
-		if (numerrors == 0)
-		    function->generate();
+		if (compiler->cache != nullptr)
+		    keyFunction(function);
+
+		if (compiler->options.memoryReport)
+		    compiler->memory.functions.push_back(make_pair(name, compiler->memory.declaration));
+
+		if (compiler->options.wholeProgram || compiler->options.jobs > 1)
+		    compiler->functions.push_back(function);
+		else if (compiler->numerrors == 0 && compiler->options.pipelined)
+		    generateLater(function);
+		else if (compiler->numerrors == 0)
+		    function->generate(*compiler->out);
 
 		return;
 	    }
 
 	} else {
 	    symbol = declareVariable(name, Type(typespec, indirection));
-	    globals.push_back(symbol);
+	    compiler->globals.push_back(symbol);
 	}
 
-	while (lookahead == ',') {
+	while (compiler->lookahead == ',') {
 	    match(',');
 	    indirection = pointers();
 	    name = expect(ID);
 
-	    if (lookahead == '[') {
+	    if (compiler->lookahead == '[') {
 		match('[');
 		symbol = declareVariable(name, Type(typespec, indirection, number()));
-		globals.push_back(symbol);
+		compiler->globals.push_back(symbol);
 		match(']');
 
-	    } else if (lookahead == '(') {
+	    } else if (compiler->lookahead == '(') {
 		match('(');
 		match(')');
 		declareFunction(name, Type(typespec, indirection, nullptr));
 
 	    } else {
 		symbol = declareVariable(name, Type(typespec, indirection));
-		globals.push_back(symbol);
+		compiler->globals.push_back(symbol);
 	    }
 	}
 
@@ -963,22 +1122,77 @@ static void topLevelDeclaration()
 
 
 /*
- * Function:	main
+ * Function:	parse
  *
- * Description:	Analyze the standard input stream.
+ * Description:	Analyze the input stream of the current compilation.  For
+ *		the whole program, code is only generated at the end, for
+ *		what main and the exported functions can reach.  Functions
+ *		generated in parallel also wait until the end.  In a
+ *		pipeline, the lexer and code generator threads must finish
+ *		before the globals and strings are written.  The return
+ *		value indicates whether the input parsed.
  */
 
-int main()
+bool parse()
 {
+    TIME("parse");
+
+    const Options &options = compiler->options;
+    Symbols &globals = compiler->globals;
+    Functions &functions = compiler->functions;
+
+
+    watchUsage(&compiler->memory.declaration);
     openScope();
-    lookahead = lexan(lexbuf);
 
-    while (lookahead != DONE)
-	topLevelDeclaration();
+    if (options.pipelined)
+	startPipeline();
+
+    if (options.debug)
+	generateFile();
+
+    try {
+	compiler->lookahead = scan(compiler->lexbuf);
 
-    if (numerrors == 0)
+	while (compiler->lookahead != DONE)
+	    topLevelDeclaration();
+
+    } catch (SyntaxError) {
+	if (options.pipelined)
+	    finishPipeline();
+
+	watchUsage(nullptr);
+	closeScope();
+	return false;
+    }
+
+    if (options.pipelined)
+	finishPipeline();
+
+    watchUsage(nullptr);
+
+    if (compiler->numerrors == 0) {
+	if (options.wholeProgram) {
+	    unsigned nfunctions = functions.size(), nglobals = globals.size();
+	    set<string> roots = options.exported;
+
+	    roots.insert("main");
+	    stripUnreachable(functions, globals, roots);
+
+	    if (options.optimizeReport) {
+		ostream &err = *compiler->err;
+
+		err << "scc: " << nfunctions - functions.size();
+		err << " unused functions and " << nglobals - globals.size();
+		err << " unused globals removed" << endl;
+	    }
+	}
+
+	generateFunctions(functions, options.jobs);
 	generateGlobals(globals);
+	generateStrings();
+    }
 
     closeScope();
-    exit(EXIT_SUCCESS);
+    return true;
 }
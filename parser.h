@@ -0,0 +1,13 @@
+/*
+ * File:	parser.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		the recursive-descent parser for Simple C.
+ */
+
+# ifndef PARSER_H
+# define PARSER_H
+
+bool parse();
+
+# endif /* PARSER_H */
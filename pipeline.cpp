@@ -0,0 +1,254 @@
+/*
+ * File:	pipeline.cpp
+ *
+ * Description:	This file contains the public and private function and
+ *		variable definitions for running the compiler as a
+ *		three-stage pipeline.  The lexer runs on its own thread and
+ *		sends batches of tokens to the parser, which runs on the
+ *		thread of the compilation along with the checker.  The parser sends each
+ *		completed function to the code generator, which also runs
+ *		on its own thread.  Each stage is connected to the next by
+ *		a bounded single-producer, single-consumer queue, so on a
+ *		stream of input the compiler runs about as fast as its
+ *		slowest stage.
+ *
+ *		The lexer thread works on a context of its own, which
+ *		shares only the input with the compilation.  Each token
+ *		carries the line on which it was found, along with any
+ *		lexical errors found reading it, so that the parser reports
+ *		errors on the same lines and in the same order, and stops
+ *		generating code at the same point, as it would without a
+ *		pipeline.
+ */
+
+# include <thread>
+# include <vector>
+# include <sstream>
+# include "lexer.h"
+# include "tokens.h"
+# include "Queue.h"
+# include "pipeline.h"
+# include "compiler.h"
+
+using namespace std;
+
+struct Token {
+    int token;
+    string lexeme;
+    int line;
+    int errors;
+    string messages;
+};
+
+typedef vector<Token> Tokens;
+
+static const unsigned BATCH = 256;
+
+struct Pipeline {
+    Queue<Tokens *, 64> tokens;
+    Queue<Function *, 64> functions;
+    thread lexer, generator;
+
+    CompilerContext scanner;
+    ostringstream messages;
+    ostream *tied;
+
+    Tokens *current;
+    unsigned position;
+    bool done;
+
+    Pipeline(CompilerContext *parent);
+};
+
+
+/*
+ * Function:	Pipeline::Pipeline (constructor)
+ *
+ * Description:	Initialize a pipeline for the given compilation.  The
+ *		scanner context continues reading where the compilation
+ *		left off.
+ */
+
+Pipeline::Pipeline(CompilerContext *parent)
+    : scanner(parent->options), current(nullptr), position(0), done(false)
+{
+    scanner.in = parent->in;
+    scanner.err = &messages;
+    scanner.c = parent->c;
+}
+
+
+/*
+ * Function:	readTokens
+ *
+ * Description:	Read the input into batches of tokens.  A batch is sent
+ *		when it is full, at the end of each top-level declaration,
+ *		or at the end of the input, so that on a stream of input
+ *		the parser never waits on a declaration that has already
+ *		been read.
+ */
+
+static void readTokens(Pipeline *pipeline)
+{
+    Tokens *batch = new Tokens();
+    unsigned depth = 0;
+    Token t;
+
+
+    compiler = &pipeline->scanner;
+
+    do {
+	t.token = lexan(t.lexeme);
+	t.line = compiler->lineno;
+	t.errors = compiler->numerrors;
+	t.messages = pipeline->messages.str();
+	batch->push_back(t);
+
+	compiler->numerrors = 0;
+	pipeline->messages.str("");
+
+	if (t.token == '{')
+	    depth ++;
+	else if (t.token == '}' && depth > 0)
+	    depth --;
+
+	if (batch->size() == BATCH || t.token == DONE ||
+		(depth == 0 && (t.token == ';' || t.token == '}'))) {
+	    pipeline->tokens.push(batch);
+	    batch = new Tokens();
+	}
+
+    } while (t.token != DONE);
+
+    delete batch;
+}
+
+
+/*
+ * Function:	generateCode
+ *
+ * Description:	Generate code for each function in turn until the null
+ *		function marking the end.  The thread works on the
+ *		compilation of its parent.
+ */
+
+static void generateCode(CompilerContext *parent)
+{
+    Function *function;
+
+
+    compiler = parent;
+
+    while ((function = parent->pipeline->functions.pop()) != nullptr)
+	function->generate(*compiler->out);
+}
+
+
+/*
+ * Function:	startPipeline
+ *
+ * Description:	Start the lexer and code generator threads for the current
+ *		compilation.  This must be called before the parser reads
+ *		any tokens.  The input is untied from any output stream
+ *		until the pipeline finishes, so that reading does not flush
+ *		the output while the code generator is writing it.
+ */
+
+void startPipeline()
+{
+    Pipeline *pipeline = new Pipeline(compiler);
+
+    compiler->pipeline = pipeline;
+    pipeline->tied = compiler->in->tie(nullptr);
+    pipeline->lexer = thread(readTokens, pipeline);
+    pipeline->generator = thread(generateCode, compiler);
+}
+
+
+/*
+ * Function:	nextBatch
+ *
+ * Description:	Replace the current batch of tokens with the next one from
+ *		the lexer thread.
+ */
+
+static void nextBatch(Pipeline *pipeline)
+{
+    delete pipeline->current;
+    pipeline->current = pipeline->tokens.pop();
+    pipeline->position = 0;
+
+    if (pipeline->current->back().token == DONE)
+	pipeline->done = true;
+}
+
+
+/*
+ * Function:	nextToken
+ *
+ * Description:	Return the next token from the lexer thread and its lexeme.
+ *		The line number follows that of the lexer when the token
+ *		was read, and any errors found reading it are reported now,
+ *		under the lock shared with the code generator thread.
+ */
+
+int nextToken(string &lexbuf)
+{
+    Pipeline *pipeline = compiler->pipeline;
+
+
+    if (pipeline->current == nullptr || pipeline->position == pipeline->current->size())
+	nextBatch(pipeline);
+
+    const Token &t = (*pipeline->current)[pipeline->position ++];
+
+    if (!t.messages.empty()) {
+	lock_guard<mutex> lock(compiler->errLock);
+	*compiler->err << t.messages;
+    }
+
+    compiler->numerrors += t.errors;
+    compiler->lineno = t.line;
+    lexbuf = t.lexeme;
+    return t.token;
+}
+
+
+/*
+ * Function:	generateLater
+ *
+ * Description:	Send a completed function to the code generator thread.
+ */
+
+void generateLater(Function *function)
+{
+    compiler->pipeline->functions.push(function);
+}
+
+
+/*
+ * Function:	finishPipeline
+ *
+ * Description:	Wait for the lexer and code generator threads to finish.
+ *		All functions sent to the code generator have been written
+ *		on return.  After a syntax error, the rest of the tokens
+ *		are read and thrown away so that the lexer can finish.
+ */
+
+void finishPipeline()
+{
+    Pipeline *pipeline = compiler->pipeline;
+
+
+    pipeline->functions.push(nullptr);
+    pipeline->generator.join();
+
+    while (!pipeline->done)
+	nextBatch(pipeline);
+
+    pipeline->lexer.join();
+    compiler->in->tie(pipeline->tied);
+    delete pipeline->current;
+    delete pipeline;
+    compiler->pipeline = nullptr;
+}
@@ -0,0 +1,19 @@
+/*
+ * File:	pipeline.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		running the lexer, parser, and code generator of Simple C
+ *		as a pipeline of threads.
+ */
+
+# ifndef PIPELINE_H
+# define PIPELINE_H
+# include <string>
+# include "Tree.h"
+
+void startPipeline();
+int nextToken(std::string &lexbuf);
+void generateLater(Function *function);
+void finishPipeline();
+
+# endif /* PIPELINE_H */
@@ -0,0 +1,65 @@
+/*
+ * File:	profile.cpp
+ *
+ * Description:	This file contains the public function definitions for
+ *		reading a profile, as written by lib/profile.c when a
+ *		program compiled with -finstrument exits.  Each line gives
+ *		a function, the number of one of its blocks, and the times
+ *		the block was entered:
+ *
+ *			function block count
+ *
+ *		A profile is appended to by each run, so the counts of a
+ *		block on several lines are added together.  The blocks of a
+ *		function are numbered in the order the code generator
+ *		reaches them, so the program must be compiled with the same
+ *		options when the profile is used.
+ */
+
+# include <fstream>
+# include <sstream>
+# include "profile.h"
+
+using namespace std;
+
+/* No function has more blocks than this; a larger number is corrupt */
+
+# define MAX_BLOCKS (1u << 20)
+
+
+/*
+ * Function:	readProfile
+ *
+ * Description:	Read the profile at PATH into PROFILE.  False is returned
+ *		if the profile cannot be read or a line is malformed, which
+ *		includes giving a block number beyond MAX_BLOCKS.
+ */
+
+bool readProfile(const string &path, Profile &profile)
+{
+    unsigned long long count;
+    string line, name;
+    unsigned block;
+
+
+    ifstream in(path.c_str());
+
+    if (!in)
+	return false;
+
+    while (getline(in, line)) {
+	istringstream fields(line);
+
+	if (!(fields >> name >> block >> count) || block >= MAX_BLOCKS)
+	    return false;
+
+	vector<unsigned long long> &counts = profile[name];
+
+	if (block >= counts.size())
+	    counts.resize(block + 1);
+
+	counts[block] += count;
+    }
+
+    return true;
+}
@@ -0,0 +1,19 @@
+/*
+ * File:	profile.h
+ *
+ * Description:	This file contains the type definition and public function
+ *		declarations for reading the block counts of a program
+ *		compiled with -finstrument.
+ */
+
+# ifndef PROFILE_H
+# define PROFILE_H
+# include <map>
+# include <string>
+# include <vector>
+
+typedef std::map<std::string, std::vector<unsigned long long> > Profile;
+
+bool readProfile(const std::string &path, Profile &profile);
+
+# endif /* PROFILE_H */
@@ -0,0 +1,294 @@
+/*
+ * File:	protocol.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for the protocol spoken between the compile
+ *		server and its clients.  A connection carries any number of
+ *		batches, one after another.  The client sends:
+ *
+ *			options
+ *			number of sources
+ *			name and source ...
+ *
+ *		and the server sends back, for each source in the order
+ *		the compilations finish:
+ *
+ *			index of the source in the batch
+ *			1 if it compiled without errors, and 0 otherwise
+ *			assembly
+ *			diagnostics
+ *
+ *		Numbers are four bytes in network order, and strings are a
+ *		number giving their length followed by their bytes.  The
+ *		options are sent as their values rather than as arguments,
+ *		so the server never has to reject one.  The name of each
+ *		source is sent with it rather than in the options, since
+ *		the sources of a batch share their options.  A string longer
+ *		than we are willing to hold ends the connection, and the
+ *		number of jobs is capped, so that one bad frame cannot
+ *		exhaust the server.
+ */
+
+# include <cstdint>
+# include <cstdlib>
+# include <algorithm>
+# include <unistd.h>
+# include <arpa/inet.h>
+# include <sys/socket.h>
+# include "protocol.h"
+
+using namespace std;
+
+# define MAX_STRING (64u << 20)
+# define MAX_JOBS 64u
+
+
+/*
+ * Function:	socketPath
+ *
+ * Description:	Return the path of the socket on which the server listens,
+ *		which is $SCCD_SOCKET if set.
+ */
+
+string socketPath()
+{
+    const char *path = getenv("SCCD_SOCKET");
+
+    return path != nullptr ? path : "/tmp/sccd.socket";
+}
+
+
+/*
+ * Function:	writeAll
+ *
+ * Description:	Write all of a buffer to a socket.  A peer that has gone
+ *		away is an error rather than a signal.
+ */
+
+static bool writeAll(int fd, const char *buf, size_t length)
+{
+    ssize_t n;
+
+    while (length > 0) {
+	if ((n = send(fd, buf, length, MSG_NOSIGNAL)) <= 0)
+	    return false;
+
+	buf += n;
+	length -= n;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	readAll
+ *
+ * Description:	Read exactly the given number of bytes from a socket.
+ */
+
+static bool readAll(int fd, char *buf, size_t length)
+{
+    ssize_t n;
+
+    while (length > 0) {
+	if ((n = read(fd, buf, length)) <= 0)
+	    return false;
+
+	buf += n;
+	length -= n;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	writeNumber
+ *
+ * Description:	Write a number to a socket.
+ */
+
+bool writeNumber(int fd, unsigned n)
+{
+    uint32_t value = htonl(n);
+
+    return writeAll(fd, (const char *) &value, sizeof(value));
+}
+
+
+/*
+ * Function:	readNumber
+ *
+ * Description:	Read a number from a socket.
+ */
+
+bool readNumber(int fd, unsigned &n)
+{
+    uint32_t value;
+
+    if (!readAll(fd, (char *) &value, sizeof(value)))
+	return false;
+
+    n = ntohl(value);
+    return true;
+}
+
+
+/*
+ * Function:	writeString
+ *
+ * Description:	Write a string to a socket.
+ */
+
+bool writeString(int fd, const string &s)
+{
+    return writeNumber(fd, s.size()) && writeAll(fd, s.data(), s.size());
+}
+
+
+/*
+ * Function:	readString
+ *
+ * Description:	Read a string from a socket.  A string that is too long
+ *		is an error.
+ */
+
+bool readString(int fd, string &s)
+{
+    unsigned length;
+
+    if (!readNumber(fd, length) || length > MAX_STRING)
+	return false;
+
+    s.resize(length);
+    return length == 0 || readAll(fd, &s[0], length);
+}
+
+
+/*
+ * Function:	writeOptions
+ *
+ * Description:	Write a set of options to a socket.
+ */
+
+bool writeOptions(int fd, const Options &options)
+{
+    set<string>::const_iterator it;
+
+    if (!writeNumber(fd, options.unrollFactor) || !writeNumber(fd, options.jobs))
+	return false;
+
+    if (!writeNumber(fd, options.optimize) || !writeNumber(fd, options.optimizeReport))
+	return false;
+
+    if (!writeNumber(fd, options.memoryReport) || !writeNumber(fd, options.codeReport))
+	return false;
+
+    if (!writeNumber(fd, options.wholeProgram) || !writeNumber(fd, options.pipelined))
+	return false;
+
+    if (!writeNumber(fd, options.instrument) || !writeString(fd, options.profileFile))
+	return false;
+
+    if (!writeNumber(fd, options.debug))
+	return false;
+
+    if (!writeNumber(fd, options.instrumentFunctions))
+	return false;
+
+    if (!writeString(fd, options.entryHook) || !writeString(fd, options.exitHook))
+	return false;
+
+    if (!writeString(fd, options.target))
+	return false;
+
+    if (!writeString(fd, options.cacheDirectory) || !writeNumber(fd, options.cacheSize))
+	return false;
+
+    if (!writeNumber(fd, options.cacheStats))
+	return false;
+
+    if (!writeNumber(fd, options.exported.size()))
+	return false;
+
+    for (it = options.exported.begin(); it != options.exported.end(); it ++)
+	if (!writeString(fd, *it))
+	    return false;
+
+    return true;
+}
+
+
+/*
+ * Function:	readOptions
+ *
+ * Description:	Read a set of options from a socket.  A factor or number of
+ *		jobs of zero is taken as one, and the number of jobs is at
+ *		most MAX_JOBS.
+ */
+
+bool readOptions(int fd, Options &options)
+{
+    unsigned optimize, optimizeReport, memoryReport, codeReport;
+    unsigned wholeProgram, pipelined, instrument, debug, count;
+    unsigned instrumentFunctions, cacheStats;
+    string name;
+
+    if (!readNumber(fd, options.unrollFactor) || !readNumber(fd, options.jobs))
+	return false;
+
+    if (!readNumber(fd, optimize) || !readNumber(fd, optimizeReport))
+	return false;
+
+    if (!readNumber(fd, memoryReport) || !readNumber(fd, codeReport))
+	return false;
+
+    if (!readNumber(fd, wholeProgram) || !readNumber(fd, pipelined))
+	return false;
+
+    if (!readNumber(fd, instrument) || !readString(fd, options.profileFile))
+	return false;
+
+    if (!readNumber(fd, debug))
+	return false;
+
+    if (!readNumber(fd, instrumentFunctions))
+	return false;
+
+    if (!readString(fd, options.entryHook) || !readString(fd, options.exitHook))
+	return false;
+
+    if (!readString(fd, options.target))
+	return false;
+
+    if (!readString(fd, options.cacheDirectory) || !readNumber(fd, options.cacheSize))
+	return false;
+
+    if (!readNumber(fd, cacheStats))
+	return false;
+
+    if (!readNumber(fd, count))
+	return false;
+
+    for (unsigned i = 0; i < count; i ++) {
+	if (!readString(fd, name))
+	    return false;
+
+	options.exported.insert(name);
+    }
+
+    options.unrollFactor = max(options.unrollFactor, 1u);
+    options.jobs = min(max(options.jobs, 1u), MAX_JOBS);
+    options.optimize = optimize;
+    options.optimizeReport = optimizeReport;
+    options.memoryReport = memoryReport;
+    options.codeReport = codeReport;
+    options.wholeProgram = wholeProgram;
+    options.pipelined = pipelined;
+    options.instrument = instrument;
+    options.debug = debug;
+    options.instrumentFunctions = instrumentFunctions;
+    options.cacheStats = cacheStats;
+    return true;
+}
@@ -0,0 +1,23 @@
+/*
+ * File:	protocol.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		the protocol spoken between the compile server and its
+ *		clients over a Unix domain socket.
+ */
+
+# ifndef PROTOCOL_H
+# define PROTOCOL_H
+# include <string>
+# include "options.h"
+
+std::string socketPath();
+
+bool writeNumber(int fd, unsigned n);
+bool readNumber(int fd, unsigned &n);
+bool writeString(int fd, const std::string &s);
+bool readString(int fd, std::string &s);
+bool writeOptions(int fd, const Options &options);
+bool readOptions(int fd, Options &options);
+
+# endif /* PROTOCOL_H */
@@ -0,0 +1,112 @@
+/*
+ * File:	scc.cpp
+ *
+ * Description:	This file contains the main program for the Simple C
+ *		compiler, which compiles the standard input to the
+ *		standard output after parsing any command-line options.
+ */
+
+# include <cstdlib>
+# include <sstream>
+# include <iostream>
+# include "cache.h"
+# include "options.h"
+# include "compiler.h"
+# include "timing.h"
+
+using namespace std;
+
+
+/*
+ * Function:	report
+ *
+ * Description:	Report the time of each phase if asked to.
+ */
+
+static void report(const Options &options)
+{
+    if (options.timeReport.empty())
+	return;
+
+    if (!reportTimes(cerr, options.timeReport == "json"))
+	cerr << "scc: -ftime-report needs a compiler built with TIMING" << endl;
+}
+
+
+/*
+ * Function:	reporting
+ *
+ * Description:	Return whether any report on the compilation is wanted.
+ */
+
+static bool reporting(const Options &options)
+{
+    if (options.optimizeReport || options.memoryReport || options.codeReport)
+	return true;
+
+    return !options.timeReport.empty();
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Compile the standard input stream with the options given on
+ *		the command line.  With a cache, a program compiled before
+ *		is not compiled again; its stored assembly is written
+ *		instead.  Otherwise the functions that have not changed are
+ *		reused by the compilation itself.  Only programs that
+ *		compile without errors are stored, and a report on the
+ *		compilation bypasses the cache since it could not be
+ *		repeated.  So does a profile, which may change without the
+ *		program; the functions are still cached, each with its own
+ *		counts.
+ */
+
+int main(int argc, char *argv[])
+{
+    string source, assembly, diagnostics, key;
+    stringstream buffer;
+    Options options;
+    bool compiled;
+
+
+    parseOptions(argc, argv, options);
+
+    if (options.cacheDirectory.empty() || reporting(options) || !options.profileFile.empty()) {
+	CompilerContext context(options);
+
+	compiled = context.compile(cin, cout, cerr);
+	report(options);
+
+	if (options.cacheStats && context.cache != nullptr)
+	    context.cache->report(cerr);
+
+	exit(compiled ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    Cache cache(options.cacheDirectory, (unsigned long) options.cacheSize << 20);
+
+    buffer << cin.rdbuf();
+    source = buffer.str();
+    key = cache.key(options, source);
+
+    if (cache.find(key, assembly))
+	compiled = true;
+    else {
+	CompilerContext context(options);
+
+	compiled = context.compile(source, assembly, diagnostics);
+
+	if (compiled)
+	    cache.insert(key, assembly);
+    }
+
+    cout << assembly;
+    cerr << diagnostics;
+
+    if (options.cacheStats)
+	cache.report(cerr);
+
+    exit(compiled ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,221 @@
+/*
+ * File:	sccc.cpp
+ *
+ * Description:	This file contains the main program for the client of the
+ *		Simple C compile server.  It takes the same options as scc,
+ *		except for -ftime-report, since the server times its phases
+ *		over every job at once.  With no files, it compiles the
+ *		standard input to the standard output, just as scc does.
+ *		Given files, it sends them to the server as one batch, each
+ *		under its own name for -g, and writes the assembly for each
+ *		file.c to file.s, prefixing any diagnostics with the name
+ *		of the file.  The sources are sent on a thread of their own
+ *		while the results are read, so that a batch too large for
+ *		the socket buffers cannot deadlock.
+ *
+ *		usage: sccc [scc options] [file.c ...]
+ */
+
+# include <string>
+# include <thread>
+# include <vector>
+# include <cerrno>
+# include <cstdlib>
+# include <cstring>
+# include <fstream>
+# include <sstream>
+# include <iostream>
+# include <unistd.h>
+# include <sys/un.h>
+# include <sys/socket.h>
+# include "options.h"
+# include "protocol.h"
+
+using namespace std;
+
+
+/*
+ * Function:	fail
+ *
+ * Description:	Report an error and exit.
+ */
+
+static void fail(const string &message)
+{
+    cerr << "sccc: " << message << endl;
+    exit(EXIT_FAILURE);
+}
+
+
+/*
+ * Function:	connectServer
+ *
+ * Description:	Connect to the compile server and return the socket.
+ */
+
+static int connectServer()
+{
+    string path = socketPath();
+    struct sockaddr_un address;
+    int fd;
+
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+	fail("socket path too long: " + path);
+
+    strcpy(address.sun_path, path.c_str());
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0 || connect(fd, (struct sockaddr *) &address, sizeof(address)) < 0)
+	fail(path + ": " + strerror(errno) + " (is sccd running?)");
+
+    return fd;
+}
+
+
+/*
+ * Function:	prefix
+ *
+ * Description:	Return the diagnostics with each line prefixed by NAME.
+ */
+
+static string prefix(const string &name, const string &diagnostics)
+{
+    istringstream in(diagnostics);
+    string line, result;
+
+    while (getline(in, line))
+	result += name + ": " + line + "\n";
+
+    return result;
+}
+
+
+/*
+ * Function:	sendBatch
+ *
+ * Description:	Send a batch of sources and their names to the server, each
+ *		name standing in for the source name of the options.  On
+ *		failure, the socket is shut down so that reading the
+ *		results fails too.
+ */
+
+static void sendBatch(int fd, const Options &options, const vector<string> &names, const vector<string> &sources)
+{
+    bool sent = writeOptions(fd, options) && writeNumber(fd, sources.size());
+
+    for (unsigned i = 0; sent && i < sources.size(); i ++)
+	sent = writeString(fd, names[i]) && writeString(fd, sources[i]);
+
+    if (!sent)
+	shutdown(fd, SHUT_RDWR);
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Send the standard input or the named files to the server
+ *		and write out what comes back.
+ */
+
+int main(int argc, char *argv[])
+{
+    vector<char *> args;
+    vector<string> files, names, sources;
+    unsigned count, index, compiled;
+    string assembly, diagnostics;
+    bool failed = false;
+    Options options;
+    char *path;
+    int fd;
+
+
+    args.push_back(argv[0]);
+
+    for (int i = 1; i < argc; i ++)
+	if (argv[i][0] == '-')
+	    args.push_back(argv[i]);
+	else
+	    files.push_back(argv[i]);
+
+    parseOptions(args.size(), &args[0], options);
+
+    if (!options.timeReport.empty())
+	fail("-ftime-report is not supported by the server; use scc");
+
+    //The server reads the profile from its own directory
+    if (!options.profileFile.empty()) {
+	if ((path = realpath(options.profileFile.c_str(), nullptr)) != nullptr) {
+	    options.profileFile = path;
+	    free(path);
+	}
+    }
+
+    //The cache may not exist yet, so it is only made absolute
+    if (!options.cacheDirectory.empty() && options.cacheDirectory[0] != '/') {
+	if ((path = getcwd(nullptr, 0)) != nullptr) {
+	    options.cacheDirectory = string(path) + "/" + options.cacheDirectory;
+	    free(path);
+	}
+    }
+
+    if (files.empty()) {
+	stringstream buffer;
+
+	buffer << cin.rdbuf();
+	names.push_back(options.sourceName);
+	sources.push_back(buffer.str());
+
+    } else {
+	for (unsigned i = 0; i < files.size(); i ++) {
+	    ifstream in(files[i].c_str());
+	    stringstream buffer;
+
+	    if (!in)
+		fail(files[i] + ": " + strerror(errno));
+
+	    buffer << in.rdbuf();
+	    names.push_back(files[i]);
+	    sources.push_back(buffer.str());
+	}
+    }
+
+    fd = connectServer();
+    thread sender(sendBatch, fd, cref(options), cref(names), cref(sources));
+
+    for (count = 0; count < sources.size(); count ++) {
+	if (!readNumber(fd, index) || !readNumber(fd, compiled) ||
+		!readString(fd, assembly) || !readString(fd, diagnostics) ||
+		index >= sources.size())
+	    fail("lost connection to server");
+
+	failed = failed || !compiled;
+
+	if (files.empty()) {
+	    cout << assembly;
+	    cerr << diagnostics;
+
+	} else {
+	    string name = files[index];
+	    size_t dot = name.rfind('.');
+
+	    if (dot != string::npos && name.substr(dot) == ".c")
+		name.erase(dot);
+
+	    ofstream out((name + ".s").c_str());
+
+	    if (!(out << assembly))
+		fail(name + ".s: " + strerror(errno));
+
+	    cerr << prefix(files[index], diagnostics);
+	}
+    }
+
+    sender.join();
+    close(fd);
+    exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
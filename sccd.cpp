@@ -0,0 +1,371 @@
+/*
+ * File:	sccd.cpp
+ *
+ * Description:	This file contains the main program for the Simple C
+ *		compile server.  The server listens on a Unix domain socket
+ *		(see protocol.cpp) and compiles each source it is sent on a
+ *		pool of threads, sending back the assembly and diagnostics
+ *		of each as soon as it is done.  A process that compiles
+ *		many programs thereby pays to start only once.  Each
+ *		connection has a thread of its own that sends the results,
+ *		so that neither the pool nor the thread reading the sources
+ *		waits on a client that is slow to read.  A job with a cache
+ *		is looked up there first, just as scc does.
+ *
+ *		usage: sccd [-pN] [socket]
+ *
+ *		-pN	compile N sources at a time (default: one per
+ *			processor)
+ */
+
+# include <atomic>
+# include <deque>
+# include <mutex>
+# include <string>
+# include <thread>
+# include <cerrno>
+# include <cstdlib>
+# include <cstring>
+# include <sstream>
+# include <algorithm>
+# include <iostream>
+# include <exception>
+# include <condition_variable>
+# include <unistd.h>
+# include <sys/un.h>
+# include <sys/socket.h>
+# include "cache.h"
+# include "compiler.h"
+# include "protocol.h"
+
+using namespace std;
+
+struct Result {
+    unsigned index;
+    bool compiled;
+    string assembly;
+    string diagnostics;
+};
+
+struct Connection {
+    int fd;
+    atomic<bool> failed;
+    bool closing;
+    unsigned pending;
+    deque<Result *> results;
+    mutex lock;
+    condition_variable ready, finished;
+};
+
+struct Job {
+    Connection *connection;
+    unsigned index;
+    Options options;
+    string source;
+};
+
+static deque<Job *> jobs;
+static mutex jobsLock;
+static condition_variable jobsReady;
+
+
+/*
+ * Function:	compileJob
+ *
+ * Description:	Compile the source of a job into its result.  With a cache,
+ *		a program compiled before is not compiled again, unless a
+ *		report or a profile is wanted (see scc.cpp).  The
+ *		statistics of the cache go into the diagnostics.
+ */
+
+static void compileJob(const Job *job, Result *result)
+{
+    const Options &options = job->options;
+    ostringstream stats;
+    string key;
+
+
+    if (options.cacheDirectory.empty() || options.optimizeReport ||
+	    options.memoryReport || options.codeReport || !options.profileFile.empty()) {
+	CompilerContext context(options);
+
+	result->compiled = context.compile(job->source, result->assembly, result->diagnostics);
+
+	if (options.cacheStats && context.cache != nullptr)
+	    context.cache->report(stats);
+
+    } else {
+	Cache cache(options.cacheDirectory, (unsigned long) options.cacheSize << 20);
+
+	key = cache.key(options, job->source);
+
+	if (cache.find(key, result->assembly))
+	    result->compiled = true;
+	else {
+	    CompilerContext context(options);
+
+	    result->compiled = context.compile(job->source, result->assembly, result->diagnostics);
+
+	    if (result->compiled)
+		cache.insert(key, result->assembly);
+	}
+
+	if (options.cacheStats)
+	    cache.report(stats);
+    }
+
+    result->diagnostics += stats.str();
+}
+
+
+/*
+ * Function:	compile
+ *
+ * Description:	Compile each job in turn, handing the result to the writer
+ *		of its connection.  Each thread of the pool runs this
+ *		forever, so a compilation that throws fails only its job.
+ */
+
+static void compile()
+{
+    Result *result;
+    Job *job;
+
+
+    while (true) {
+	{
+	    unique_lock<mutex> lock(jobsLock);
+
+	    while (jobs.empty())
+		jobsReady.wait(lock);
+
+	    job = jobs.front();
+	    jobs.pop_front();
+	}
+
+	result = new Result();
+	result->index = job->index;
+
+	try {
+	    compileJob(job, result);
+
+	} catch (const exception &e) {
+	    result->compiled = false;
+	    result->assembly.clear();
+	    result->diagnostics = string("sccd: ") + e.what() + "\n";
+	}
+
+	Connection *connection = job->connection;
+
+	{
+	    lock_guard<mutex> lock(connection->lock);
+	    connection->results.push_back(result);
+	}
+
+	connection->ready.notify_one();
+	delete job;
+    }
+}
+
+
+/*
+ * Function:	reply
+ *
+ * Description:	Send the results of a connection as they are handed over,
+ *		until the connection is closing and none are left.  No lock
+ *		is held while sending.
+ */
+
+static void reply(Connection *connection)
+{
+    int fd = connection->fd;
+    Result *result;
+
+
+    while (true) {
+	{
+	    unique_lock<mutex> lock(connection->lock);
+
+	    while (connection->results.empty() && !connection->closing)
+		connection->ready.wait(lock);
+
+	    if (connection->results.empty())
+		return;
+
+	    result = connection->results.front();
+	    connection->results.pop_front();
+	}
+
+	if (!connection->failed)
+	    connection->failed = !writeNumber(fd, result->index) ||
+		!writeNumber(fd, result->compiled) ||
+		!writeString(fd, result->assembly) ||
+		!writeString(fd, result->diagnostics);
+
+	delete result;
+
+	{
+	    lock_guard<mutex> lock(connection->lock);
+
+	    if (-- connection->pending == 0)
+		connection->finished.notify_one();
+	}
+    }
+}
+
+
+/*
+ * Function:	receive
+ *
+ * Description:	Read batches from a connection until the client closes it,
+ *		queueing a job for each source.  A batch must be finished
+ *		before the next is read, so that its results all go back on
+ *		the connection before it is closed.  Options for a target
+ *		machine we do not know end the connection.
+ */
+
+static void receive(Connection *connection)
+{
+    int fd = connection->fd;
+    unsigned count;
+    Options options;
+    Job *job;
+
+
+    while (!connection->failed && readOptions(fd, options) &&
+	    findMachine(options.target) != nullptr && readNumber(fd, count)) {
+	for (unsigned i = 0; i < count; i ++) {
+	    job = new Job();
+	    job->connection = connection;
+	    job->index = i;
+	    job->options = options;
+
+	    if (!readString(fd, job->options.sourceName) || !readString(fd, job->source)) {
+		delete job;
+		break;
+	    }
+
+	    connection->lock.lock();
+	    connection->pending ++;
+	    connection->lock.unlock();
+
+	    jobsLock.lock();
+	    jobs.push_back(job);
+	    jobsLock.unlock();
+	    jobsReady.notify_one();
+	}
+
+	unique_lock<mutex> lock(connection->lock);
+
+	while (connection->pending > 0)
+	    connection->finished.wait(lock);
+
+	options = Options();
+    }
+}
+
+
+/*
+ * Function:	serve
+ *
+ * Description:	Serve a connection on a thread of its own.  Anything thrown
+ *		while reading ends only this connection, once the jobs it
+ *		has already queued are done.
+ */
+
+static void serve(int fd)
+{
+    Connection *connection = new Connection();
+
+
+    connection->fd = fd;
+    connection->failed = false;
+    connection->closing = false;
+    connection->pending = 0;
+
+    thread writer(reply, connection);
+
+    try {
+	receive(connection);
+
+    } catch (const exception &e) {
+	cerr << "sccd: " << e.what() << endl;
+	connection->failed = true;
+    }
+
+    {
+	unique_lock<mutex> lock(connection->lock);
+
+	while (connection->pending > 0)
+	    connection->finished.wait(lock);
+
+	connection->closing = true;
+    }
+
+    connection->ready.notify_one();
+    writer.join();
+
+    close(fd);
+    delete connection;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Start the pool of compiling threads, then listen for
+ *		connections, serving each on a thread of its own.
+ */
+
+int main(int argc, char *argv[])
+{
+    unsigned threads = thread::hardware_concurrency();
+    string path = socketPath();
+    struct sockaddr_un address;
+    int listener, fd;
+
+
+    for (int i = 1; i < argc; i ++) {
+	if (strncmp(argv[i], "-p", 2) == 0 && atoi(argv[i] + 2) > 0)
+	    threads = atoi(argv[i] + 2);
+	else if (argv[i][0] != '-')
+	    path = argv[i];
+	else {
+	    cerr << "usage: sccd [-pN] [socket]" << endl;
+	    exit(EXIT_FAILURE);
+	}
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path)) {
+	cerr << "sccd: socket path too long: " << path << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    strcpy(address.sun_path, path.c_str());
+    unlink(path.c_str());
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+	cerr << "sccd: " << path << ": " << strerror(errno) << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    for (unsigned i = 0; i < max(threads, 1u); i ++)
+	thread(compile).detach();
+
+    while (true) {
+	if ((fd = accept(listener, nullptr, nullptr)) < 0) {
+	    if (errno == EINTR)
+		continue;
+
+	    cerr << "sccd: accept: " << strerror(errno) << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	thread(serve, fd).detach();
+    }
+}
@@ -0,0 +1,181 @@
+/*
+ * File:	timing.cpp
+ *
+ * Description:	This file contains the member and public function
+ *		definitions for timing the phases of the compiler.  Each
+ *		place that is timed has a phase of its own, created the
+ *		first time it runs and linked into a list of all phases.
+ *		Phases with the same name, such as the check functions of
+ *		one family, are added together in the report.
+ *
+ *		Each thread keeps a stack of its running timers, so that a
+ *		timer can take the time of the phases it called from its
+ *		own.  The time of a phase is therefore exclusive, and the
+ *		times of all the phases add up to the time that was timed.
+ */
+
+# include <map>
+# include <mutex>
+# include <string>
+# include <vector>
+# include <iomanip>
+# include <algorithm>
+# include "timing.h"
+
+using namespace std;
+
+# ifdef TIMING
+
+static mutex phasesLock;
+static Phase *phases;
+static thread_local Timer *current;
+
+
+/*
+ * Function:	Phase::Phase (constructor)
+ *
+ * Description:	Initialize a phase and add it to the list of all phases.
+ */
+
+Phase::Phase(const char *name)
+    : _name(name), _calls(0), _nanoseconds(0)
+{
+    lock_guard<mutex> lock(phasesLock);
+
+    _next = phases;
+    phases = this;
+}
+
+
+/*
+ * Function:	Phase::charge
+ *
+ * Description:	Charge one call of the given length to the phase.
+ */
+
+void Phase::charge(unsigned long nanoseconds)
+{
+    _calls ++;
+    _nanoseconds += nanoseconds;
+}
+
+
+/*
+ * Function:	Timer::Timer (constructor)
+ *
+ * Description:	Start timing a call of a phase.
+ */
+
+Timer::Timer(Phase &phase)
+    : _phase(phase), _parent(current), _children(0)
+{
+    current = this;
+    _start = chrono::steady_clock::now();
+}
+
+
+/*
+ * Function:	Timer::~Timer (destructor)
+ *
+ * Description:	Stop timing a call, charging the phase for the time not
+ *		spent in the phases it called, and the caller for all of
+ *		it.
+ */
+
+Timer::~Timer()
+{
+    chrono::steady_clock::duration elapsed;
+    unsigned long nanoseconds;
+
+
+    elapsed = chrono::steady_clock::now() - _start;
+    nanoseconds = chrono::duration_cast<chrono::nanoseconds>(elapsed).count();
+
+    _phase.charge(nanoseconds > _children ? nanoseconds - _children : 0);
+
+    if (_parent != nullptr)
+	_parent->_children += nanoseconds;
+
+    current = _parent;
+}
+
+
+/*
+ * Function:	slower
+ *
+ * Description:	Order the phases in the report from slowest to fastest.
+ */
+
+typedef pair<string, pair<unsigned long, unsigned long> > Total;
+
+static bool slower(const Total &a, const Total &b)
+{
+    return a.second.second > b.second.second;
+}
+
+# endif /* TIMING */
+
+
+/*
+ * Function:	reportTimes
+ *
+ * Description:	Write the number of calls and the time of each phase, as a
+ *		table or as JSON.  False is returned if the compiler was
+ *		built without timing.
+ */
+
+bool reportTimes(ostream &out, bool json)
+{
+# ifdef TIMING
+    map<string, pair<unsigned long, unsigned long> > totals;
+    vector<Total> sorted;
+    unsigned long total = 0;
+    const Phase *phase;
+
+
+    {
+	lock_guard<mutex> lock(phasesLock);
+
+	for (phase = phases; phase != nullptr; phase = phase->next()) {
+	    totals[phase->name()].first += phase->calls();
+	    totals[phase->name()].second += phase->nanoseconds();
+	    total += phase->nanoseconds();
+	}
+    }
+
+    sorted.assign(totals.begin(), totals.end());
+    stable_sort(sorted.begin(), sorted.end(), slower);
+    out << fixed;
+
+    if (json) {
+	out << "{\"phases\": [";
+
+	for (unsigned i = 0; i < sorted.size(); i ++) {
+	    out << (i > 0 ? ", " : "") << "{\"name\": \"" << sorted[i].first << "\", ";
+	    out << "\"calls\": " << sorted[i].second.first << ", ";
+	    out << "\"seconds\": " << setprecision(6) << sorted[i].second.second / 1e9 << "}";
+	}
+
+	out << "], \"seconds\": " << total / 1e9 << "}" << endl;
+
+    } else {
+	out << left << setw(24) << "phase" << right << setw(12) << "calls";
+	out << setw(12) << "seconds" << setw(8) << "%" << endl;
+
+	for (unsigned i = 0; i < sorted.size(); i ++) {
+	    out << left << setw(24) << sorted[i].first << right;
+	    out << setw(12) << sorted[i].second.first;
+	    out << setw(12) << setprecision(6) << sorted[i].second.second / 1e9;
+	    out << setw(8) << setprecision(1);
+	    out << (total > 0 ? 100.0 * sorted[i].second.second / total : 0) << endl;
+	}
+
+	out << left << setw(36) << "total" << right << setw(12);
+	out << setprecision(6) << total / 1e9 << endl;
+    }
+
+    return true;
+# else
+    return false;
+# endif
+}
@@ -0,0 +1,59 @@
+/*
+ * File:	timing.h
+ *
+ * Description:	This file contains the class definitions and macros for
+ *		timing the phases of the compiler.  A phase is timed by
+ *		placing TIME("name") at the start of a function; every call
+ *		is counted, and the time spent in the function is charged
+ *		to its phase, less the time spent in any phase it calls.
+ *
+ *		Unless the compiler is built with TIMING defined, TIME
+ *		expands to nothing, so the timers cost nothing at all.
+ */
+
+# ifndef TIMING_H
+# define TIMING_H
+# include <ostream>
+
+# ifdef TIMING
+# include <atomic>
+# include <chrono>
+
+class Phase {
+    const char *_name;
+    std::atomic<unsigned long> _calls, _nanoseconds;
+    Phase *_next;
+
+public:
+    Phase(const char *name);
+
+    const char *name() const { return _name; }
+    unsigned long calls() const { return _calls; }
+    unsigned long nanoseconds() const { return _nanoseconds; }
+    const Phase *next() const { return _next; }
+
+    void charge(unsigned long nanoseconds);
+};
+
+class Timer {
+    Phase &_phase;
+    Timer *_parent;
+    unsigned long _children;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    Timer(Phase &phase);
+    ~Timer();
+};
+
+# define TIME(name) static Phase phase_(name); Timer timer_(phase_)
+
+# else
+
+# define TIME(name)
+
+# endif /* TIMING */
+
+bool reportTimes(std::ostream &out, bool json);
+
+# endif /* TIMING_H */